@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "arrivals.h"
+
+/* ******************************************************************
+   Arrival logs, see arrivals.h
+**********************************************************************/
+
+#define ARRIVALS_LINEMAX 256
+
+struct arrivals {
+  double *times;          /* relative to the first arrival */
+  int *sizes;
+  long n, cap;
+};
+
+/* make room for one more message, returns -1 if out of memory */
+static int grow(struct arrivals *ar)
+{
+  double *times;
+  int *sizes;
+  long cap;
+
+  if (ar->n < ar->cap)
+    return 0;
+  cap = ar->cap > 0 ? 2 * ar->cap : 1024;
+  times = realloc(ar->times, cap * sizeof(double));
+  if (times == NULL)
+    return -1;
+  ar->times = times;
+  sizes = realloc(ar->sizes, cap * sizeof(int));
+  if (sizes == NULL)
+    return -1;
+  ar->sizes = sizes;
+  ar->cap = cap;
+  return 0;
+}
+
+struct arrivals *arrivals_load(const char *path, int maxsize)
+{
+  struct arrivals *ar;
+  char line[ARRIVALS_LINEMAX];
+  double t;
+  int size, fields;
+  long lineno = 0;
+  FILE *fp;
+
+  fp = fopen(path, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "unable to open arrival log %s\n", path);
+    return NULL;
+  }
+  ar = calloc(1, sizeof(struct arrivals));
+  if (ar == NULL) {
+    printf("memory allocation for arrival log failed.");
+    exit(EXIT_FAILURE);
+  }
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lineno++;
+    size = 0;
+    fields = sscanf(line, "%lf %d", &t, &size);
+    if (fields < 1) {
+      if (strspn(line, " \t\r\n") == strlen(line) || line[strspn(line, " \t")] == '#')
+        continue;
+      fprintf(stderr, "%s:%ld: expected a time and an optional size\n", path, lineno);
+      break;
+    }
+    if ((ar->n > 0 && t < ar->times[ar->n - 1])
+        || (fields == 2 && (size < 1 || size > maxsize))) {
+      fprintf(stderr, "%s:%ld: times must not decrease, sizes must be 1 to %d\n",
+              path, lineno, maxsize);
+      break;
+    }
+    if (grow(ar) != 0) {
+      printf("memory allocation for arrival log failed.");
+      exit(EXIT_FAILURE);
+    }
+    ar->times[ar->n] = t;
+    ar->sizes[ar->n] = size;
+    ar->n++;
+  }
+  if (!feof(fp) || ar->n == 0) {
+    if (feof(fp))
+      fprintf(stderr, "arrival log %s holds no arrivals\n", path);
+    fclose(fp);
+    arrivals_free(ar);
+    return NULL;
+  }
+  fclose(fp);
+  return ar;
+}
+
+long arrivals_length(const struct arrivals *ar)
+{
+  return ar->n;
+}
+
+double arrivals_time(const struct arrivals *ar, long i)
+{
+  return ar->times[i] - ar->times[0];
+}
+
+int arrivals_size(const struct arrivals *ar, long i)
+{
+  return ar->sizes[i];
+}
+
+void arrivals_free(struct arrivals *ar)
+{
+  free(ar->times);
+  free(ar->sizes);
+  free(ar);
+}
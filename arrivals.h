@@ -0,0 +1,34 @@
+/* ******************************************************************
+   Arrival logs: application message arrivals to replay.
+
+   An arrival log is a text file with one message per line, the time it
+   reached the application and optionally its size in bytes (the run's
+   payload if not given).  Times must not decrease.  They are taken
+   relative to the first one, so a log with absolute timestamps replays
+   from time 0.  Blank lines and lines starting with # are skipped.
+   With -workload trace the emulator offers the logged messages at
+   their times, once through the log.
+**********************************************************************/
+
+#ifndef ARRIVALS_H
+#define ARRIVALS_H
+
+struct arrivals;          /* one loaded log, see arrivals.c */
+
+/* read a log whose sizes are at most maxsize; prints why and returns
+   NULL if it cannot be used */
+extern struct arrivals *arrivals_load(const char *path, int maxsize);
+
+/* number of messages in the log */
+extern long arrivals_length(const struct arrivals *ar);
+
+/* arrival time of message i, relative to the first */
+extern double arrivals_time(const struct arrivals *ar, long i);
+
+/* size of message i, 0 if the log does not give one */
+extern int arrivals_size(const struct arrivals *ar, long i);
+
+/* release the log */
+extern void arrivals_free(struct arrivals *ar);
+
+#endif
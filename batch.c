@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "batch.h"
+
+/* ******************************************************************
+   Batch means, see batch.h
+**********************************************************************/
+
+void batch_init(struct batchmeans *bm)
+{
+  bm->x = NULL;
+  bm->n = bm->cap = 0;
+}
+
+void batch_add(struct batchmeans *bm, double x)
+{
+  double *grown;
+  int cap;
+
+  if (bm->n == bm->cap) {
+    cap = bm->cap > 0 ? 2 * bm->cap : 64;
+    grown = realloc(bm->x, cap * sizeof(double));
+    if (grown == NULL) {
+      printf("memory allocation for batch means failed.");
+      exit(EXIT_FAILURE);
+    }
+    bm->x = grown;
+    bm->cap = cap;
+  }
+  bm->x[bm->n++] = x;
+}
+
+/* MSER: the d minimising the sum of squared deviations of batches d..n-1
+   from their mean over (n-d)^2.  The sums are built from the back, so
+   every d costs a constant. */
+int batch_warmup(const struct batchmeans *bm)
+{
+  double sum = 0.0, sumsq = 0.0, k, ss, score, best = -1.0;
+  int d, bestd = 0;
+
+  for (d = bm->n - 1; d >= 0; d--) {
+    sum += bm->x[d];
+    sumsq += bm->x[d] * bm->x[d];
+    if (d > bm->n / 2)
+      continue;
+    k = bm->n - d;
+    ss = sumsq - sum * sum / k;
+    score = (ss > 0.0 ? ss : 0.0) / (k * k);
+    if (best < 0.0 || score <= best) {
+      best = score;
+      bestd = d;
+    }
+  }
+  return bestd;
+}
+
+void batch_ci(const struct batchmeans *bm, int from, double *mean, double *halfwidth)
+{
+  double x, m = 0.0, ss = 0.0;
+  int i, k = bm->n - from;
+
+  /* Welford's update, as for the replications */
+  for (i = 0; i < k; i++) {
+    x = bm->x[from + i];
+    ss += (x - m) * (x - m) * i / (i + 1);
+    m += (x - m) / (i + 1);
+  }
+  *mean = m;
+  *halfwidth = k > 1 ? batch_tcrit95(k - 1) * sqrt(ss / (k - 1)) / sqrt((double)k) : 0.0;
+}
+
+void batch_free(struct batchmeans *bm)
+{
+  free(bm->x);
+  batch_init(bm);
+}
+
+double batch_tcrit95(int df)
+{
+  static const double t[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+
+  if (df <= 30)
+    return t[df - 1];
+  return 1.960 + 2.5 / df;     /* within 0.002 of the exact value */
+}
@@ -0,0 +1,41 @@
+/* ******************************************************************
+   Batch means, for stopping a run once its statistics have converged.
+
+   A long run is cut into batches of equal simulated time and the mean
+   of a statistic over each batch is added to a series.  Batches long
+   enough to be nearly independent make the spread of their means an
+   estimate of how far the overall mean can be trusted, from one run.
+   The first batches are biased by the run starting empty; they are
+   found with MSER (White's Marginal Standard Error Rule), which drops
+   the d leading batches that minimise the standard error of the rest,
+   d at most half the series.
+**********************************************************************/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+struct batchmeans {
+  double *x;                /* the batch means, oldest first */
+  int n, cap;
+};
+
+/* empty the series */
+extern void batch_init(struct batchmeans *bm);
+
+/* add the mean of the batch just ended */
+extern void batch_add(struct batchmeans *bm, double x);
+
+/* number of leading batches MSER takes to be warm-up */
+extern int batch_warmup(const struct batchmeans *bm);
+
+/* mean of the batches from the given one on, and the half-width of its
+   95% confidence interval; 0 half-width with fewer than two batches */
+extern void batch_ci(const struct batchmeans *bm, int from, double *mean, double *halfwidth);
+
+/* release the series */
+extern void batch_free(struct batchmeans *bm);
+
+/* two sided 95% critical value of Student's t with df degrees of freedom */
+extern double batch_tcrit95(int df);
+
+#endif
@@ -0,0 +1,76 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "bintrace.h"
+
+/* ******************************************************************
+   Binary event trace ring, see bintrace.h
+**********************************************************************/
+
+struct bintrace {
+  struct btrec *ring;     /* preallocated record ring */
+  long capacity;          /* records the ring holds */
+  long nextrec;           /* slot the next record goes in */
+  long total;             /* records appended so far */
+  char *outpath;          /* file the ring is written to */
+};
+
+struct bintrace *bintrace_open(const char *path, long nrecs)
+{
+  struct bintrace *bt;
+
+  bt = malloc(sizeof(struct bintrace));
+  if (bt != NULL) {
+    bt->capacity = (nrecs > 0) ? nrecs : BT_DEFAULTRECS;
+    bt->ring = malloc(bt->capacity * sizeof(struct btrec));
+    bt->outpath = malloc(strlen(path) + 1);
+  }
+  if (bt == NULL || bt->ring == NULL || bt->outpath == NULL) {
+    printf("memory allocation for binary trace failed.");
+    exit(EXIT_FAILURE);
+  }
+  strcpy(bt->outpath, path);
+  bt->nextrec = 0;
+  bt->total = 0;
+  return bt;
+}
+
+void bintrace_record(struct bintrace *bt, const struct btrec *rec)
+{
+  bt->ring[bt->nextrec] = *rec;
+  if (++bt->nextrec == bt->capacity)
+    bt->nextrec = 0;
+  bt->total++;
+}
+
+void bintrace_close(struct bintrace *bt)
+{
+  struct bthdr hdr;
+  FILE *fp;
+  long first;
+
+  memset(&hdr, 0, sizeof(hdr));
+  strcpy(hdr.magic, BT_MAGIC);
+  hdr.recsize = sizeof(struct btrec);
+  hdr.nrecs = (bt->total < bt->capacity) ? bt->total : bt->capacity;
+  hdr.dropped = bt->total - hdr.nrecs;
+
+  fp = fopen(bt->outpath, "wb");
+  if (fp == NULL) {
+    printf("unable to open binary trace file %s\n", bt->outpath);
+    exit(EXIT_FAILURE);
+  }
+  /* oldest record is at nextrec once the ring has wrapped */
+  first = (bt->total < bt->capacity) ? 0 : bt->nextrec;
+  if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1
+      || fwrite(bt->ring + first, sizeof(struct btrec), hdr.nrecs - first, fp) != (size_t)(hdr.nrecs - first)
+      || fwrite(bt->ring, sizeof(struct btrec), first, fp) != (size_t)first) {
+    printf("error writing binary trace file %s\n", bt->outpath);
+    exit(EXIT_FAILURE);
+  }
+  fclose(fp);
+
+  free(bt->ring);
+  free(bt->outpath);
+  free(bt);
+}
@@ -0,0 +1,59 @@
+/* ******************************************************************
+   Binary event trace.
+
+   When enabled, the emulator's main loop appends one fixed size record
+   per simulated event to a ring buffer allocated up front, so recording
+   costs a few stores rather than a formatted printf.  Only the newest
+   records are kept if the ring wraps.  The ring is written out when the
+   simulation ends and can be turned into text or CSV with tracedecode.
+
+   File layout: a struct bthdr followed by hdr.nrecs struct btrec, oldest
+   first.  Records use the native byte order and type sizes, so decode
+   on the kind of machine that recorded the trace.
+**********************************************************************/
+
+#ifndef BINTRACE_H
+#define BINTRACE_H
+
+#define BT_MAGIC     "RTBTRC2"   /* 7 characters plus the terminator */
+#define BT_DEFAULTRECS 1048576L  /* default ring size in records */
+
+/* outcome flags, set from what the event handler did */
+#define BT_CORRUPT   0x01   /* packet was corrupted in the medium */
+#define BT_NEWACK    0x02   /* handler counted a new ACK */
+#define BT_RESENT    0x04   /* handler retransmitted a packet */
+#define BT_WINFULL   0x08   /* message dropped because the window was full */
+#define BT_NOMSG     0x10   /* layer 5 arrival after the last message */
+
+struct bthdr {
+  char magic[8];          /* BT_MAGIC */
+  long recsize;           /* sizeof(struct btrec) when recorded */
+  long nrecs;             /* records that follow */
+  long dropped;           /* older records overwritten in the ring */
+};
+
+struct btrec {
+  double time;            /* simulated time of the event */
+  int seqnum;             /* seqnum of the arriving packet, else -1 */
+  int acknum;             /* acknum of the arriving packet, else -1 */
+  int flow;               /* flow of the entity the event is for, see -flows */
+  unsigned char type;     /* 0 timer interrupt, 1 from layer 5, 2 from layer 3 */
+  unsigned char entity;   /* 0 A, 1 B */
+  unsigned char flags;    /* BT_* outcome flags */
+  unsigned char unused;
+  unsigned short nsent;       /* packets handed to layer 3 by the handler */
+  unsigned short ndelivered;  /* messages delivered to layer 5 by the handler */
+};
+
+struct bintrace;          /* one recording, see bintrace.c */
+
+/* start recording into a ring of nrecs records, written to path at close */
+extern struct bintrace *bintrace_open(const char *path, long nrecs);
+
+/* append a record, overwriting the oldest one if the ring is full */
+extern void bintrace_record(struct bintrace *bt, const struct btrec *rec);
+
+/* write the ring out and release it */
+extern void bintrace_close(struct bintrace *bt);
+
+#endif
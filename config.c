@@ -0,0 +1,427 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "config.h"
+#include "emulator.h"
+#include "bintrace.h"
+#include "sampler.h"
+
+/* ******************************************************************
+   Command line and config file handling, see config.h
+**********************************************************************/
+
+#define LINEMAX 512     /* longest config file line */
+
+/* parameter types */
+#define P_INT    0
+#define P_LONG   1
+#define P_ULONG  2
+#define P_FLOAT  3
+#define P_STR    4     /* string of up to CONFIG_PATHMAX - 1 chars */
+
+struct param {
+  const char *name;       /* flag without the '-', or config file key */
+  int type;               /* P_* */
+  size_t offset;          /* field in struct simconfig */
+  const char *help;
+};
+
+#define FIELD(f) offsetof(struct simconfig, f)
+
+static const struct param params[] = {
+  { "messages",  P_INT,   FIELD(nsimmax),          "number of messages to simulate" },
+  { "loss",      P_FLOAT, FIELD(lossprob),         "packet loss probability" },
+  { "corrupt",   P_FLOAT, FIELD(corruptprob),      "packet corruption probability" },
+  { "direction", P_INT,   FIELD(corruptdirection), "loss/corruption direction: 0 A->B, 1 A<-B, 2 both" },
+  { "lambda",    P_FLOAT, FIELD(lambda),           "average time between messages from layer 5" },
+  { "trace",     P_INT,   FIELD(trace),            "TRACE level" },
+  { "seed",      P_ULONG, FIELD(seed),             "random number generator seed" },
+  { "tracefile", P_STR,   FIELD(tracefile),        "write TRACE output to this file" },
+  { "bintrace",  P_STR,   FIELD(bintrace),         "record a binary event trace to this file" },
+  { "bintracerecs", P_LONG, FIELD(bintracerecs),   "binary trace ring size in records" },
+  { "replica",   P_INT,   FIELD(replica),          "replication number, selects independent random streams" },
+  { "replications", P_INT, FIELD(replications),    "independent runs to make and summarise" },
+  { "threads",   P_INT,   FIELD(threads),          "threads for replications, 0 for one per CPU" },
+  { "protocol",  P_STR,   FIELD(protocol),         "protocol: sr, gbn or sw" },
+  { "window",    P_INT,   FIELD(windowsize),       "send window size, 0 for the protocol's default" },
+  { "seqspace",  P_INT,   FIELD(seqspace),         "sequence number space, 0 for the protocol's default" },
+  { "sweep",     P_STR,   FIELD(sweep),            "sweep parameters, e.g. \"loss=0:0.3:0.1 window=2,4,8\"" },
+  { "samplefile", P_STR,  FIELD(samplefile),       "write a time series of the counters to this file" },
+  { "sampleinterval", P_FLOAT, FIELD(sampleinterval), "simulated time between samples" },
+  { "samplerecs", P_LONG, FIELD(samplerecs),       "sample ring size in samples" },
+  { "format",    P_STR,   FIELD(format),           "result output: text, json or csv" },
+  { "forkat",    P_FLOAT, FIELD(forkat),           "snapshot time: replications and sweep points branch from here" },
+  { "snapshot",  P_STR,   FIELD(snapshot),         "write the snapshot taken at forkat to this file and stop" },
+  { "resume",    P_STR,   FIELD(resume),           "carry on from this snapshot file, with any flags that follow" },
+  { "bitrate",   P_FLOAT, FIELD(bitrate),          "bottleneck link bits per time unit, 0 for the original channel" },
+  { "propdelay", P_FLOAT, FIELD(propdelay),        "link propagation delay" },
+  { "buffer",    P_INT,   FIELD(buffer),           "link buffer in packets, 0 for unlimited" },
+  { "bufferbytes", P_LONG, FIELD(bufferbytes),     "link buffer in bytes, 0 for unlimited" },
+  { "lossmodel", P_STR,   FIELD(lossmodel),        "bernoulli, or gilbert for bursts of loss" },
+  { "tobad",     P_FLOAT, FIELD(tobad),            "gilbert: per packet probability of entering the bad state" },
+  { "togood",    P_FLOAT, FIELD(togood),           "gilbert: per packet probability of leaving it" },
+  { "badloss",   P_FLOAT, FIELD(badloss),          "gilbert: loss probability in the bad state (loss in the good)" },
+  { "reorder",   P_FLOAT, FIELD(reorderprob),      "probability that a packet is held back and overtaken" },
+  { "reordermax", P_FLOAT, FIELD(reordermax),      "longest a packet is held back, or its duplicate follows" },
+  { "duplicate", P_FLOAT, FIELD(dupprob),          "packet duplication probability" },
+  { "impairdirection", P_INT, FIELD(impairdirection), "reorder/duplicate direction: 0 A->B, 1 A<-B, 2 both" },
+  { "pathab",    P_STR,   FIELD(pathab),           "replay A->B loss, corruption and delay from this path trace" },
+  { "pathba",    P_STR,   FIELD(pathba),           "replay B->A loss, corruption and delay from this path trace" },
+  { "flows",     P_INT,   FIELD(flows),            "sender/receiver pairs sharing the channel" },
+  { "bidirectional", P_INT, FIELD(bidirectional),  "1 for messages from B to A too, 0 for A to B only" },
+  { "ackdelay",  P_FLOAT, FIELD(ackdelay),         "bidirectional: longest an ACK waits to ride on data, 0 to send at once" },
+  { "payload",   P_INT,   FIELD(payload),          "message size in bytes, or the largest with minpayload" },
+  { "minpayload", P_INT,  FIELD(minpayload),       "smallest message size, sizes uniform up to payload; 0 for fixed" },
+  { "workload",  P_STR,   FIELD(workload),         "arrivals: uniform, poisson, onoff, saturated or trace" },
+  { "onmean",    P_FLOAT, FIELD(onmean),           "onoff: mean length of the periods with arrivals" },
+  { "offmean",   P_FLOAT, FIELD(offmean),          "onoff: mean length of the periods without" },
+  { "burstshape", P_FLOAT, FIELD(burstshape),      "onoff: Pareto shape of the period lengths, > 1" },
+  { "arrivals",  P_STR,   FIELD(arrivals),         "trace: replay message arrivals from this log" },
+  { "stopci",    P_FLOAT, FIELD(stopci),           "stop once throughput and latency CIs are within this fraction, 0 for never" },
+  { "batchtime", P_FLOAT, FIELD(batchtime),        "stopci: simulated time per batch" },
+  { "minbatches", P_INT,  FIELD(minbatches),       "stopci: fewest batches after the warm-up to stop on" }
+};
+
+#define NPARAMS ((int)(sizeof(params) / sizeof(params[0])))
+
+void config_defaults(struct simconfig *cfg)
+{
+  memset(cfg, 0, sizeof(*cfg));
+  cfg->nsimmax = 1000;
+  cfg->lossprob = 0.0;
+  cfg->corruptprob = 0.0;
+  cfg->corruptdirection = 2;
+  cfg->lambda = 10.0;
+  cfg->trace = 0;
+  cfg->seed = 9999;
+  cfg->tracefile[0] = '\0';
+  cfg->bintrace[0] = '\0';
+  cfg->bintracerecs = BT_DEFAULTRECS;
+  cfg->replica = 0;
+  cfg->replications = 1;
+  cfg->threads = 0;
+  strcpy(cfg->protocol, "sr");
+  cfg->windowsize = 0;
+  cfg->seqspace = 0;
+  cfg->sweep[0] = '\0';
+  cfg->samplefile[0] = '\0';
+  cfg->sampleinterval = 100.0;
+  cfg->samplerecs = SAMPLER_DEFAULTRECS;
+  strcpy(cfg->format, "text");
+  cfg->forkat = 0.0;
+  cfg->snapshot[0] = '\0';
+  cfg->resume[0] = '\0';
+  cfg->bitrate = 0.0;
+  cfg->propdelay = 5.0;
+  cfg->buffer = 0;
+  cfg->bufferbytes = 0;
+  strcpy(cfg->lossmodel, "bernoulli");
+  cfg->tobad = 0.0;
+  cfg->togood = 1.0;
+  cfg->badloss = 1.0;
+  cfg->reorderprob = 0.0;
+  cfg->reordermax = 10.0;
+  cfg->dupprob = 0.0;
+  cfg->impairdirection = 2;
+  cfg->flows = 1;
+  cfg->bidirectional = 0;
+  cfg->ackdelay = 2.0;
+  cfg->payload = 20;
+  cfg->minpayload = 0;
+  strcpy(cfg->workload, "uniform");
+  cfg->onmean = 1000.0;
+  cfg->offmean = 1000.0;
+  cfg->burstshape = 1.5;
+  cfg->arrivals[0] = '\0';
+  cfg->stopci = 0.0;
+  cfg->batchtime = 1000.0;
+  cfg->minbatches = 10;
+}
+
+int config_set(struct simconfig *cfg, const char *name, const char *value)
+{
+  const struct param *p = NULL;
+  char *field;
+  char *end;
+  int i;
+
+  for (i = 0; i < NPARAMS; i++)
+    if (strcmp(params[i].name, name) == 0)
+      p = &params[i];
+  if (p == NULL) {
+    fprintf(stderr, "unknown parameter %s\n", name);
+    return -1;
+  }
+
+  field = (char *)cfg + p->offset;
+  switch (p->type) {
+  case P_INT:
+    *(int *)field = (int)strtol(value, &end, 10);
+    break;
+  case P_LONG:
+    *(long *)field = strtol(value, &end, 10);
+    break;
+  case P_ULONG:
+    *(unsigned long *)field = strtoul(value, &end, 10);
+    break;
+  case P_FLOAT:
+    *(float *)field = (float)strtod(value, &end);
+    break;
+  default:
+    if (strlen(value) >= CONFIG_PATHMAX) {
+      fprintf(stderr, "%s: value too long\n", name);
+      return -1;
+    }
+    strcpy(field, value);
+    return 0;
+  }
+  if (end == value || *end != '\0') {
+    fprintf(stderr, "%s: bad value '%s'\n", name, value);
+    return -1;
+  }
+  return 0;
+}
+
+/* strip leading and trailing white space in place */
+static char *trim(char *s)
+{
+  char *end;
+
+  while (isspace((unsigned char)*s))
+    s++;
+  end = s + strlen(s);
+  while (end > s && isspace((unsigned char)end[-1]))
+    end--;
+  *end = '\0';
+  return s;
+}
+
+int config_load(struct simconfig *cfg, const char *path)
+{
+  FILE *fp;
+  char line[LINEMAX];
+  char *name, *value, *eq;
+  int lineno = 0;
+  int status = 0;
+
+  fp = fopen(path, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "unable to open config file %s\n", path);
+    return -1;
+  }
+  while (status == 0 && fgets(line, sizeof(line), fp) != NULL) {
+    lineno++;
+    if ((eq = strchr(line, '#')) != NULL)    /* drop comments */
+      *eq = '\0';
+    name = trim(line);
+    if (*name == '\0')
+      continue;
+    eq = strchr(name, '=');
+    if (eq == NULL) {
+      fprintf(stderr, "%s:%d: expected name = value\n", path, lineno);
+      status = -1;
+      break;
+    }
+    *eq = '\0';
+    value = trim(eq + 1);
+    name = trim(name);
+    if (config_set(cfg, name, value) != 0) {
+      fprintf(stderr, "%s:%d: in this line\n", path, lineno);
+      status = -1;
+    }
+  }
+  fclose(fp);
+  return status;
+}
+
+int config_parse_args(struct simconfig *cfg, int argc, char **argv)
+{
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "-help") == 0)
+      return -1;
+    if (argv[i][0] != '-' || argv[i][1] == '\0') {
+      fprintf(stderr, "unexpected argument %s\n", argv[i]);
+      return -1;
+    }
+    if (i + 1 == argc) {
+      fprintf(stderr, "%s needs a value\n", argv[i]);
+      return -1;
+    }
+    if (strcmp(argv[i], "-config") == 0) {
+      if (config_load(cfg, argv[++i]) != 0)
+        return -1;
+    }
+    else if (config_set(cfg, argv[i] + 1, argv[i + 1]) != 0)
+      return -1;
+    else
+      i++;
+  }
+  return 0;
+}
+
+void config_prompt(struct simconfig *cfg)
+{
+  printf("-----  Stop and Wait Network Simulator Version 1.1 -------- \n\n");
+  printf("Enter the number of messages to simulate: ");
+  fflush(stdout);
+  scanf("%d",&cfg->nsimmax);
+  printf("Enter  packet loss probability [enter 0.0 for no loss]:");
+  fflush(stdout);
+  scanf("%f",&cfg->lossprob);
+  printf("Enter packet corruption probability [0.0 for no corruption]:");
+  fflush(stdout);
+  scanf("%f",&cfg->corruptprob);
+  if (cfg->lossprob != 0.0 || cfg->corruptprob != 0.0) {
+    printf("If you want loss or corruption to only occur in one direction, choose the direction: 0 A->B, 1 A<-B, 2 A<->B (both directions) :");
+    fflush(stdout);
+    scanf("%d",&cfg->corruptdirection);
+  }
+  printf("Enter average time between messages from sender's layer5 [ > 0.0]:");
+  fflush(stdout);
+  scanf("%f",&cfg->lambda);
+  printf("Enter TRACE:");
+  fflush(stdout);
+  scanf("%d",&cfg->trace);
+}
+
+int config_check(const struct simconfig *cfg)
+{
+  if (cfg->nsimmax < 0) {
+    fprintf(stderr, "messages must not be negative\n");
+    return -1;
+  }
+  if (cfg->lossprob < 0.0 || cfg->lossprob > 1.0
+      || cfg->corruptprob < 0.0 || cfg->corruptprob > 1.0) {
+    fprintf(stderr, "loss and corrupt must be probabilities in [0,1]\n");
+    return -1;
+  }
+  if (cfg->corruptdirection < 0 || cfg->corruptdirection > 2) {
+    fprintf(stderr, "direction must be 0, 1 or 2\n");
+    return -1;
+  }
+  if (strcmp(cfg->lossmodel, "bernoulli") != 0 && strcmp(cfg->lossmodel, "gilbert") != 0) {
+    fprintf(stderr, "lossmodel must be bernoulli or gilbert\n");
+    return -1;
+  }
+  if (cfg->tobad < 0.0 || cfg->tobad > 1.0 || cfg->togood < 0.0 || cfg->togood > 1.0
+      || cfg->badloss < 0.0 || cfg->badloss > 1.0 || cfg->reorderprob < 0.0
+      || cfg->reorderprob > 1.0 || cfg->dupprob < 0.0 || cfg->dupprob > 1.0) {
+    fprintf(stderr, "tobad, togood, badloss, reorder and duplicate must be probabilities in [0,1]\n");
+    return -1;
+  }
+  if (cfg->reordermax < 0.0 || cfg->impairdirection < 0 || cfg->impairdirection > 2) {
+    fprintf(stderr, "reordermax must not be negative, impairdirection must be 0, 1 or 2\n");
+    return -1;
+  }
+  if (cfg->lambda <= 0.0) {
+    fprintf(stderr, "lambda must be > 0\n");
+    return -1;
+  }
+  if (strcmp(cfg->format, "text") != 0 && strcmp(cfg->format, "json") != 0
+      && strcmp(cfg->format, "csv") != 0) {
+    fprintf(stderr, "format must be text, json or csv\n");
+    return -1;
+  }
+  if (cfg->forkat < 0.0 || (cfg->snapshot[0] != '\0' && cfg->forkat <= 0.0)) {
+    fprintf(stderr, "forkat must be > 0 to take a snapshot\n");
+    return -1;
+  }
+  if (cfg->resume[0] != '\0' && (cfg->sweep[0] != '\0' || cfg->replications > 1
+                                || cfg->forkat > 0.0)) {
+    fprintf(stderr, "resume carries on one run; use forkat with sweep to branch in memory\n");
+    return -1;
+  }
+  if (cfg->bitrate < 0.0 || cfg->propdelay < 0.0 || cfg->bufferbytes < 0
+      || cfg->buffer < 0 || cfg->buffer > LINKQMAX) {
+    fprintf(stderr, "bitrate, propdelay and bufferbytes must not be negative, buffer must be 0 to %d\n", LINKQMAX);
+    return -1;
+  }
+  if (cfg->bidirectional < 0 || cfg->bidirectional > 1 || cfg->ackdelay < 0.0) {
+    fprintf(stderr, "bidirectional must be 0 or 1, ackdelay must not be negative\n");
+    return -1;
+  }
+  if (cfg->payload < 1 || cfg->payload > MAXPAYLOAD
+      || cfg->minpayload < 0 || cfg->minpayload > cfg->payload) {
+    fprintf(stderr, "payload must be 1 to %d, minpayload 0 to payload\n", MAXPAYLOAD);
+    return -1;
+  }
+  if (strcmp(cfg->workload, "uniform") != 0 && strcmp(cfg->workload, "poisson") != 0
+      && strcmp(cfg->workload, "onoff") != 0 && strcmp(cfg->workload, "saturated") != 0
+      && strcmp(cfg->workload, "trace") != 0) {
+    fprintf(stderr, "workload must be uniform, poisson, onoff, saturated or trace\n");
+    return -1;
+  }
+  if (cfg->onmean <= 0.0 || cfg->offmean <= 0.0 || cfg->burstshape <= 1.0) {
+    fprintf(stderr, "onmean and offmean must be > 0, burstshape > 1\n");
+    return -1;
+  }
+  if ((strcmp(cfg->workload, "trace") == 0) != (cfg->arrivals[0] != '\0')) {
+    fprintf(stderr, "arrivals is needed with, and only with, workload trace\n");
+    return -1;
+  }
+  if (cfg->stopci < 0.0 || cfg->batchtime <= 0.0 || cfg->minbatches < 2) {
+    fprintf(stderr, "stopci must not be negative, batchtime must be > 0, minbatches >= 2\n");
+    return -1;
+  }
+  if (cfg->flows < 1 || cfg->flows > FLOWMAX) {
+    fprintf(stderr, "flows must be 1 to %d\n", FLOWMAX);
+    return -1;
+  }
+  if (cfg->sampleinterval <= 0.0) {
+    fprintf(stderr, "sampleinterval must be > 0\n");
+    return -1;
+  }
+  if (cfg->windowsize < 0 || cfg->seqspace < 0) {
+    fprintf(stderr, "window and seqspace must not be negative\n");
+    return -1;
+  }
+  if (cfg->replica < 0 || cfg->replications < 1 || cfg->threads < 0) {
+    fprintf(stderr, "replica and threads must not be negative, replications must be >= 1\n");
+    return -1;
+  }
+  return 0;
+}
+
+int config_nparams(void)
+{
+  return NPARAMS;
+}
+
+const char *config_paramname(int i)
+{
+  return params[i].name;
+}
+
+int config_paramvalue(const struct simconfig *cfg, int i, char *value)
+{
+  const char *field = (const char *)cfg + params[i].offset;
+
+  switch (params[i].type) {
+  case P_INT:   sprintf(value, "%d", *(const int *)field); break;
+  case P_LONG:  sprintf(value, "%ld", *(const long *)field); break;
+  case P_ULONG: sprintf(value, "%lu", *(const unsigned long *)field); break;
+  case P_FLOAT: sprintf(value, "%g", *(const float *)field); break;
+  default:      strcpy(value, field); return 1;
+  }
+  return 0;
+}
+
+void config_usage(const char *progname)
+{
+  struct simconfig def;
+  char value[CONFIG_PATHMAX];
+  int i;
+
+  config_defaults(&def);
+  fprintf(stderr, "usage: %s [-config file] [-name value ...]\n", progname);
+  fprintf(stderr, "with no arguments the parameters are read from stdin prompts\n\n");
+  for (i = 0; i < NPARAMS; i++) {
+    if (config_paramvalue(&def, i, value) && value[0] == '\0')
+      strcpy(value, "none");
+    fprintf(stderr, "  -%-14s %s (default %s)\n", params[i].name, params[i].help, value);
+  }
+}
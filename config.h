@@ -0,0 +1,114 @@
+/* ******************************************************************
+   Simulator configuration.
+
+   A run is described by a struct simconfig.  It starts from the
+   defaults below and can be filled in from command line flags, from a
+   config file, or (with no arguments at all) from the original
+   interactive prompts.  Flags and config file keys share one name
+   table, so
+
+       sr -messages 1000 -loss 0.1 -lambda 10
+
+   and a file containing
+
+       # comment
+       messages = 1000
+       loss = 0.1
+       lambda = 10
+
+   describe the same run.  -config FILE reads a file in place, so flags
+   after it override the file.
+**********************************************************************/
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define CONFIG_PATHMAX 256      /* longest file name or string a config can hold */
+#define LINKQMAX 4096           /* largest link buffer in packets */
+#define FLOWMAX 1000000         /* most flows in one run */
+
+struct simconfig {
+  int nsimmax;              /* number of msgs to generate, then stop */
+  float lossprob;           /* probability that a packet is dropped */
+  float corruptprob;        /* probability that one bit is packet is flipped */
+  int corruptdirection;     /* 0 A->B, 1 A<-B, 2 both directions */
+  float lambda;             /* average time between messages from layer 5 */
+  int trace;                /* TRACE level */
+  unsigned long seed;       /* random number generator seed */
+  char tracefile[CONFIG_PATHMAX];  /* TRACE output file, "" for stdout */
+  char bintrace[CONFIG_PATHMAX];   /* binary event trace file, "" for none */
+  long bintracerecs;        /* binary trace ring size in records */
+  int replica;              /* which replication this run is, picks its
+                               random streams */
+  int replications;         /* independent runs to make, see runner.h */
+  int threads;              /* threads to run them on, 0 for one per CPU */
+  char protocol[CONFIG_PATHMAX];   /* "sr", "gbn" or "sw", see protocol.h */
+  int windowsize;           /* protocol send window, 0 for its default */
+  int seqspace;             /* protocol sequence space, 0 for its default */
+  char sweep[CONFIG_PATHMAX];      /* parameter ranges to sweep, see sweep.h */
+  char samplefile[CONFIG_PATHMAX]; /* time series file, "" for none */
+  float sampleinterval;     /* simulated time between samples */
+  long samplerecs;          /* sample ring size in samples */
+  char format[CONFIG_PATHMAX];     /* result output: "text", "json" or "csv" */
+  float forkat;             /* time to snapshot the run at, 0 for never */
+  char snapshot[CONFIG_PATHMAX];   /* write the snapshot here and stop */
+  char resume[CONFIG_PATHMAX];     /* carry on from this snapshot file */
+  float bitrate;            /* link bits per time unit, 0 for no link model */
+  float propdelay;          /* link propagation delay */
+  int buffer;               /* link buffer in packets, 0 for unlimited */
+  long bufferbytes;         /* link buffer in bytes, 0 for unlimited */
+  char lossmodel[CONFIG_PATHMAX];  /* "bernoulli" or "gilbert" */
+  float tobad;              /* Gilbert-Elliott good to bad state probability */
+  float togood;             /* and bad to good, per packet */
+  float badloss;            /* loss probability in the bad state */
+  float reorderprob;        /* probability that a packet is held back */
+  float reordermax;         /* longest it is held back, or a copy follows */
+  float dupprob;            /* probability that a packet is duplicated */
+  int impairdirection;      /* reordering/duplication direction, as above */
+  char pathab[CONFIG_PATHMAX];      /* path trace to replay A->B, "" for none */
+  char pathba[CONFIG_PATHMAX];      /* and B->A */
+  int flows;                /* A and B pairs sharing the channel */
+  int bidirectional;        /* B sends messages to A too */
+  float ackdelay;           /* longest an ACK waits for data to carry it */
+  int payload;              /* message size in bytes, or the largest */
+  int minpayload;           /* smallest message size, 0 for all of payload */
+  char workload[CONFIG_PATHMAX];   /* layer 5 arrival process, see -workload */
+  float onmean;             /* onoff: mean on period */
+  float offmean;            /* onoff: mean off period */
+  float burstshape;         /* onoff: Pareto shape of the periods */
+  char arrivals[CONFIG_PATHMAX];   /* trace: arrival log to replay */
+  float stopci;             /* stop at this relative CI half-width, 0 for never */
+  float batchtime;          /* simulated time per batch for the stopping rule */
+  int minbatches;           /* fewest batches past the warm-up to stop on */
+};
+
+/* fill in the defaults */
+extern void config_defaults(struct simconfig *cfg);
+
+/* set one parameter by name, returns 0 or -1 if name or value is bad */
+extern int config_set(struct simconfig *cfg, const char *name, const char *value);
+
+/* read "name = value" lines from a file, returns 0 or -1 on error */
+extern int config_load(struct simconfig *cfg, const char *path);
+
+/* apply command line flags, returns 0 or -1 on error */
+extern int config_parse_args(struct simconfig *cfg, int argc, char **argv);
+
+/* ask for the parameters on stdin, as the original emulator did */
+extern void config_prompt(struct simconfig *cfg);
+
+/* check that the parameters make sense, returns 0 or -1 */
+extern int config_check(const struct simconfig *cfg);
+
+/* print the flags and their defaults */
+extern void config_usage(const char *progname);
+
+/* the parameters by index, for writing a configuration out */
+extern int config_nparams(void);
+extern const char *config_paramname(int i);
+
+/* format parameter i of cfg into value, which must hold CONFIG_PATHMAX
+   chars; returns 1 if it is a string, 0 if it is a number */
+extern int config_paramvalue(const struct simconfig *cfg, int i, char *value);
+
+#endif
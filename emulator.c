@@ -1,478 +1,1767 @@
-/* ***** THIS FILE SHOULD NOT BE MODIFIED ****************************
-   THERE IS NOT REASON THAT ANY STUDENT SHOULD HAVE TO READ OR UNDERSTAND
-   THE CODE BELOW.  YOU SHOLD NOT TOUCH, OR REFERENCE (in your code) ANY
-   OF THE DATA STRUCTURES BELOW.  If you're interested in how I designed
-   the emulator, you're welcome to look at the code - but again, you should have
-   to, and you defeinitely should not have to modify
-   This file contains the code that emulates the network.  It does not
-   implement any of the Go-Back-N protocol.
-   ********************************************************************
-
-   ******************************************************************
-   ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
-   The code below emulates the layer 3 and below network environment:
-   - emulates the tranmission and delivery (possibly with bit-level corruption
-   and packet loss) of packets across the layer 3/4 interface
-   - handles the starting/stopping of a timer, and generates timer
-   interrupts (resulting in calling students timer handler).
-   - generates message to be sent (passed from later 5 to 4)
-
-   Network properties:
-   - one way network delay averages five time units (longer if there
-   are other messages in the channel for GBN), but can be larger
-   - packets can be corrupted (either the header or the data portion)
-   or lost, according to user-defined probabilities
-   - packets will be delivered in the order in which they were sent
-   (although some can be lost).
-
-   Modifications (6/6/2008 - CLP): 
-   - removed bidirectional GBN code and other code not used by prac. 
-   - removed hard coded maximum random number, use library defined
-   RAND_MAX value 
-   - simulator stops when no events are left rather than stopping as
-   soon as n packets are sent.
-   - fixed C style to adhere to current programming style
-
-   ********************************************************************* */
-#include <stdlib.h>
-#include <stdio.h>
-#include "emulator.h"
-#include "gbn.h"
-
-struct event {
-  float evtime;           /* event time */
-  int evtype;             /* event type code */
-  int eventity;           /* entity where event occurs */
-  struct pkt *pktptr;     /* ptr to packet (if any) assoc w/ this event */
-  struct event *prev;
-  struct event *next;
-};
-
-struct event *evlist = NULL;   /* the event list */
-
-/* possible events: */
-#define  TIMER_INTERRUPT 0  
-#define  FROM_LAYER5     1
-#define  FROM_LAYER3     2
-
-#define  OFF             0
-#define  ON              1
-
-int TRACE = 3;
-
-/* statistics updated by GBN */
-int window_full;   /* count of the number of messages dropped due to full window */
-int total_ACKs_received;
-int packets_resent;       /* count of the number of packets resent  */
-int new_ACKs;           /* count of the number of acks correctly received */
-int packets_received;  /* count of the packets received by receiver */
-
-/* statistics updated by emulator */
-static int packets_lost;  
-static int packets_corrupt;
-static int packets_sent;
-static int packets_timeout;
-static int messages_delivered;
-
-static int nsim = 0;              /* number of messages from 5 to 4 so far */ 
-static int nsimmax = 0;           /* number of msgs to generate, then stop */
-static float time = 0.000;
-static float lossprob;            /* probability that a packet is dropped  */
-static float corruptprob;   /* probability that one bit is packet is flipped */
-static int corruptdirection; /* A->B A<-B or bidirectional corruption/loss */
-static float lambda;        /* arrival rate of messages from layer 5 */   
-static int   ntolayer3;           /* number sent into layer 3 */
-static int   nlost;               /* number lost in media */
-static int ncorrupt;              /* number corrupted by media*/
-
-/****************************************************************************/
-/* jimsrand(): return a double in range [0,1].  The routine below is used to */
-/* isolate all random number generation in one location.  We assume that the*/
-/* system-supplied rand() function return an int in therange [0,mmm]        */
-/****************************************************************************/
-double jimsrand(void) 
-{
-  double mmm = RAND_MAX;     /* largest int  - MACHINE DEPENDENT!!!!!!!!   */
-  double x;                   
-  x = rand()/mmm;            /* x should be uniform in [0,1] */
-  if (TRACE > 3)
-    printf("RANDOM NUMBER GENERAION CALLED: %f\n", x);
-  return(x);
-}  
-
-/********************* EVENT HANDLINE ROUTINES *******/
-/*  The next set of routines handle the event list   */
-/*****************************************************/
-
-void insertevent(struct event *p)
-{
-  struct event *q,*qold;
-
-  if (TRACE>2) {
-    printf("            INSERTEVENT: time is %f\n",time);
-    printf("            INSERTEVENT: future time will be %f\n",p->evtime); 
-  }
-  q = evlist;     /* q points to front of list in which p struct inserted */
-  if (q==NULL) {   /* list is empty */
-    evlist=p;
-    p->next=NULL;
-    p->prev=NULL;
-  }
-  else {
-    for (qold = q; q !=NULL && p->evtime > q->evtime; q=q->next)
-      qold=q; 
-    if (q==NULL) {   /* end of list */
-      qold->next = p;
-      p->prev = qold;
-      p->next = NULL;
-    }
-    else if (q==evlist) { /* front of list */
-      p->next=evlist;
-      p->prev=NULL;
-      p->next->prev=p;
-      evlist = p;
-    }
-    else {     /* middle of list */
-      p->next=q;
-      p->prev=q->prev;
-      q->prev->next=p;
-      q->prev=p;
-    }
-  }
-}
-
-void generate_next_arrival(void)
-{
-  double x;
-  struct event *evptr;
-
-  if (TRACE>2)
-    printf("          GENERATE NEXT ARRIVAL: creating new arrival\n");
- 
-  x = lambda*jimsrand()*2;  /* x is uniform on [0,2*lambda] */
-  /* having mean of lambda        */
-  evptr = malloc(sizeof(struct event));
-  if (evptr == 0) {
-    printf("memory allocation for event failed.");
-    exit(EXIT_FAILURE);
-  }
-  evptr->evtime =  time + x;
-  evptr->evtype =  FROM_LAYER5;
-  if (BIDIRECTIONAL && (jimsrand()>0.5) )
-    evptr->eventity = B;
-  else
-    evptr->eventity = A;
-  insertevent(evptr);
-} 
-
-void printevlist(void)
-{
-  struct event *q;
-  printf("--------------\nEvent List Follows:\n");
-  for(q = evlist; q!=NULL; q=q->next) {
-    printf("Event time: %f, type: %d entity: %d\n",q->evtime,q->evtype,q->eventity);
-  }
-  printf("--------------\n");
-}
-
-void init(void)                         /* initialize the simulator */
-{
-  float sum, avg;
-  int i;
-
-  printf("-----  Stop and Wait Network Simulator Version 1.1 -------- \n\n");
-  printf("Enter the number of messages to simulate: ");
-  scanf("%d",&nsimmax);
-  printf("Enter  packet loss probability [enter 0.0 for no loss]:");
-  scanf("%f",&lossprob);
-  printf("Enter packet corruption probability [0.0 for no corruption]:");
-  scanf("%f",&corruptprob);
-  if (lossprob != 0.0 || corruptprob != 0.0) {
-    printf("If you want loss or corruption to only occur in one direction, choose the direction: 0 A->B, 1 A<-B, 2 A<->B (both directions) :");
-    scanf("%d",&corruptdirection);
-  }
-  printf("Enter average time between messages from sender's layer5 [ > 0.0]:");
-  scanf("%f",&lambda);
-  printf("Enter TRACE:");
-  scanf("%d",&TRACE);
-
-
-  srand(9999);              /* init random number generator */
-  sum = 0.0;                /* test random number generator for students */
-  for (i=0; i<1000; i++)
-    sum+=jimsrand();    /* jimsrand() should be uniform in [0,1] */
-  avg = sum/1000.0;
-  if (avg < 0.25 || avg > 0.75) {
-    printf("It is likely that random number generation on your machine\n" ); 
-    printf("is different from what this emulator expects.  Please take\n");
-    printf("a look at the routine jimsrand() in the emulator code. Sorry. \n");
-    exit(EXIT_FAILURE);
-  }
-
-  /* initialise statistics */
-  window_full = 0;
-  total_ACKs_received = 0;
-  packets_resent = 0;
-  new_ACKs = 0;
-  packets_received = 0;
-  packets_lost = 0;  
-  packets_corrupt = 0;
-  packets_sent = 0;
-  packets_timeout = 0;
-  messages_delivered = 0;
-
-  ntolayer3 = 0;
-  nlost = 0;
-  ncorrupt = 0;
-
-  time=0.0;                    /* initialize time to 0.0 */
-  generate_next_arrival();     /* initialize event list */
-}
-
-/********************** Student-callable ROUTINES ***********************/
-
-/* called by students routine to cancel a previously-started timer */
-void stoptimer(int AorB)
-/* A or B is trying to stop timer */
-{
-  struct event *q;
-
-  if (TRACE>1)
-    printf("          STOP TIMER: stopping timer at %f\n",time);
-  /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next)  */
-  for (q=evlist; q!=NULL ; q = q->next) 
-    if ( (q->evtype==TIMER_INTERRUPT  && q->eventity==AorB) ) { 
-      /* remove this event */
-      if (q->next==NULL && q->prev==NULL)
-        evlist=NULL;         /* remove first and only event on list */
-      else if (q->next==NULL) /* end of list - there is one in front */
-        q->prev->next = NULL;
-      else if (q==evlist) { /* front of list - there must be event after */
-        q->next->prev=NULL;
-        evlist = q->next;
-      }
-      else {     /* middle of list */
-        q->next->prev = q->prev;
-        q->prev->next =  q->next;
-      }
-      free(q);
-      return;
-    }
-  printf("Warning: unable to cancel your timer. It wasn't running.\n");
-}
-
-
-void starttimer(int AorB, double increment)
-/* A or B is trying to start timer */
-{
-
-  struct event *q;
-  struct event *evptr;
-
-  if (TRACE>1)
-    printf("          START TIMER: starting timer at %f\n",time);
-  /* be nice: check to see if timer is already started, if so, then  warn */
-  /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next)  */
-  for (q=evlist; q!=NULL ; q = q->next)  
-    if ( (q->evtype==TIMER_INTERRUPT  && q->eventity==AorB) ) { 
-      printf("Warning: attempt to start a timer that is already started\n");
-      return;
-    }
- 
-  /* create future event for when timer goes off */
-  evptr = malloc(sizeof(struct event));
-  if (evptr == 0) {
-    printf("memory allocation for event failed.");
-    exit(EXIT_FAILURE);
-  }
-  evptr->evtime =  time + increment;
-  evptr->evtype =  TIMER_INTERRUPT;
-   
- 
-  evptr->eventity = AorB;
-  insertevent(evptr);
-} 
-
-
-/************************** TOLAYER3 ***************/
-void tolayer3(int AorB, struct pkt packet)
-/* A or B is sending to network  */
-{
-  struct pkt *mypktptr;
-  struct event *evptr,*q;
-  float lastime, x;
-  int i;
-
-  ntolayer3++;
-
-  /* simulate losses: */
-  if (jimsrand() < lossprob && (!(AorB == B && corruptdirection == A) && !(AorB == A && corruptdirection == B))) {
-    nlost++;
-    if (TRACE>0)    
-      printf("          TOLAYER3: packet being lost\n");
-    return;
-  }  
-
-  /* make a copy of the packet student just gave me since he/she may decide */
-  /* to do something with the packet after we return back to him/her */ 
-  mypktptr = malloc(sizeof(struct pkt));
-  if (mypktptr == 0) {
-    printf("memory allocation for event failed.");
-    exit(EXIT_FAILURE);
-  }
-  mypktptr->seqnum = packet.seqnum;
-  mypktptr->acknum = packet.acknum;
-  mypktptr->checksum = packet.checksum;
-  for (i=0; i<20; i++)
-    mypktptr->payload[i] = packet.payload[i];
-  if (TRACE>2)  {
-    printf("          TOLAYER3: seq: %d, ack %d, check: %d ", mypktptr->seqnum,
-           mypktptr->acknum,  mypktptr->checksum);
-    for (i=0; i<20; i++)
-      printf("%c",mypktptr->payload[i]);
-    printf("\n");
-  }
-
-  /* create future event for arrival of packet at the other side */
-  evptr = malloc(sizeof(struct event));
-  if (evptr == 0) {
-    printf("memory allocation for event failed.");
-    exit(EXIT_FAILURE);
-  }
-  evptr->evtype =  FROM_LAYER3;   /* packet will pop out from layer3 */
-  evptr->eventity = (AorB+1) % 2; /* event occurs at other entity */
-  evptr->pktptr = mypktptr;       /* save ptr to my copy of packet */
-  /* finally, compute the arrival time of packet at the other end.
-     medium can not reorder, so make sure packet arrives between 1 and 10
-     time units after the latest arrival time of packets
-     currently in the medium on their way to the destination */
-  lastime = time;
-  /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next) */
-  for (q=evlist; q!=NULL ; q = q->next) 
-    if ( (q->evtype==FROM_LAYER3  && q->eventity==evptr->eventity) ) 
-      lastime = q->evtime;
-  evptr->evtime =  lastime + 1 + 9*jimsrand();
- 
-
-
-  /* simulate corruption: */
-  if ((jimsrand() < corruptprob)  && (!(AorB == B && corruptdirection == A) && !(AorB == A && corruptdirection == B))) {
-    ncorrupt++;
-    if ( (x = jimsrand()) < .75)
-      mypktptr->payload[0]='Z';   /* corrupt payload */
-    else if (x < .875)
-      mypktptr->seqnum = 999999;
-    else
-      mypktptr->acknum = 999999;
-    if (TRACE>0)    
-      printf("          TOLAYER3: packet being corrupted\n");
-  }  
-
-  if (TRACE>2)  
-    printf("          TOLAYER3: scheduling arrival on other side\n");
-  insertevent(evptr);
-} 
-
-void tolayer5(int AorB, char datasent[20])
-{
-  int i;  
-  if (TRACE>2) {
-    printf("          TOLAYER5: data received by application at ");
-    if (AorB == A) 
-      printf("A: ");
-    else
-      printf("B: ");
-    for (i=0; i<20; i++)  
-      printf("%c",datasent[i]);
-    printf("\n");
-  }
-  messages_delivered++;
-}
-
-int main(void)
-{
-  struct event *eventptr;
-  struct msg  msg2give;
-  struct pkt  pkt2give;
-   
-  int i,j;
-  
-  init();
-  A_init();
-  B_init();
-   
-  while (1) {
-    eventptr = evlist;            /* get next event to simulate */
-    if (eventptr==NULL)
-      goto terminate;
-    evlist = evlist->next;        /* remove this event from event list */
-    if (evlist!=NULL)
-      evlist->prev=NULL;
-    if (TRACE>=2) {
-      printf("\nEVENT time: %f,",eventptr->evtime);
-      printf("  type: %d",eventptr->evtype);
-      if (eventptr->evtype==0)
-        printf(", timerinterrupt  ");
-      else if (eventptr->evtype==1)
-        printf(", fromlayer5 ");
-      else
-        printf(", fromlayer3 ");
-      printf(" entity: %d\n",eventptr->eventity);
-    }
-    time = eventptr->evtime;        /* update time to next event time */
-    if (eventptr->evtype == FROM_LAYER5 ) {
-      if (nsim < nsimmax) {
-        generate_next_arrival();   /* set up future arrival */
-        /* fill in msg to give with string of same letter */    
-        j = nsim % 26; 
-        for (i=0; i<20; i++)  
-          msg2give.data[i] = 97 + j;
-        if (TRACE>2) {
-          printf("          MAINLOOP: data given to student: ");
-          for (i=0; i<20; i++) 
-            printf("%c", msg2give.data[i]);
-          printf("\n");
-        }
-        nsim++;
-        if (eventptr->eventity == A) 
-          A_output(msg2give);  
-        else
-          B_output(msg2give);  
-      }
-      else if (TRACE > 2)
-          printf("          FROM_LAYER5: no more messages to send: \n");
-    }
-    else if (eventptr->evtype ==  FROM_LAYER3) {
-      pkt2give.seqnum = eventptr->pktptr->seqnum;
-      pkt2give.acknum = eventptr->pktptr->acknum;
-      pkt2give.checksum = eventptr->pktptr->checksum;
-      for (i=0; i<20; i++)  
-        pkt2give.payload[i] = eventptr->pktptr->payload[i];
-	    if (eventptr->eventity ==A)      /* deliver packet by calling */
-        A_input(pkt2give);            /* appropriate entity */
-      else
-        B_input(pkt2give);
-	    free(eventptr->pktptr);          /* free the memory for packet */
-    }
-    else if (eventptr->evtype ==  TIMER_INTERRUPT) {
-      if (eventptr->eventity == A) 
-        A_timerinterrupt();
-      else
-        B_timerinterrupt();
-    }
-    else  {
-      printf("INTERNAL PANIC: unknown event type \n");
-    }
-    free(eventptr);
-  }
-
- terminate:
-  printf(" Simulator terminated at time %f\n after attempting to send %d msgs from layer5\n",time,nsim);
-  printf("number of messages dropped due to full window:  %d \n", window_full);
-  printf("number of valid (not corrupt or duplicate) acknowledgements received at A:  %d \n", new_ACKs);
-  printf("(note: a single acknowledgement may have acknowledged more than one packet - if cumulative acknowledgements are used)\n");
-  printf("number of packet resends by A:  %d \n", packets_resent);
-  printf("number of correct packets received at B:  %d \n", packets_received);
-  printf("number of messages delivered to application:  %d \n", messages_delivered);
-  return EXIT_SUCCESS;
-}
\ No newline at end of file
+/* ***** THIS FILE SHOULD NOT BE MODIFIED ****************************
+   THERE IS NOT REASON THAT ANY STUDENT SHOULD HAVE TO READ OR UNDERSTAND
+   THE CODE BELOW.  YOU SHOLD NOT TOUCH, OR REFERENCE (in your code) ANY
+   OF THE DATA STRUCTURES BELOW.  If you're interested in how I designed
+   the emulator, you're welcome to look at the code - but again, you should have
+   to, and you defeinitely should not have to modify
+   This file contains the code that emulates the network.  It does not
+   implement any of the Go-Back-N protocol.
+   ********************************************************************
+
+   ******************************************************************
+   ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
+   The code below emulates the layer 3 and below network environment:
+   - emulates the tranmission and delivery (possibly with bit-level corruption
+   and packet loss) of packets across the layer 3/4 interface
+   - handles the starting/stopping of a timer, and generates timer
+   interrupts (resulting in calling students timer handler).
+   - generates message to be sent (passed from later 5 to 4)
+
+   Network properties:
+   - one way network delay averages five time units (longer if there
+   are other messages in the channel for GBN), but can be larger
+   - packets can be corrupted (either the header or the data portion)
+   or lost, according to user-defined probabilities
+   - packets will be delivered in the order in which they were sent
+   (although some can be lost).
+
+   Modifications (6/6/2008 - CLP): 
+   - removed bidirectional GBN code and other code not used by prac. 
+   - removed hard coded maximum random number, use library defined
+   RAND_MAX value 
+   - simulator stops when no events are left rather than stopping as
+   soon as n packets are sent.
+   - fixed C style to adhere to current programming style
+
+   Modifications (performance):
+   - the event list is a binary min-heap rather than a sorted linked
+   list, so inserting and removing an event is O(log n)
+   - each entity keeps a handle to its pending timer event, so starting
+   and stopping a timer no longer searches the event list
+   - the latest arrival time scheduled towards each entity is cached, so
+   tolayer3() keeps the channel FIFO without searching the event list
+   - events and packet copies come from free-list slab pools instead of
+   a malloc()/free() pair each
+   - packets travel inline in their arrival event and are handed to the
+   receiving entity straight from it, rather than through two copies
+   - random numbers come from a built-in xoshiro128** generator with a
+   separate stream for arrivals, loss, corruption and delay, instead of
+   the C library rand()
+   - trace output goes through the TRACEF() macro into a fully buffered
+   sink; levels above TRACE_MAX are compiled out (see trace.h)
+   - optional binary event trace, one fixed size record per event in a
+   preallocated ring (see bintrace.h); decode it with tracedecode
+   - parameters come from command line flags or a config file (see
+   config.h); the stdin prompts are only used when there are no arguments
+
+   - all simulator state lives in a struct sim that is passed to the
+   protocol callbacks, so one process can run many simulations (see sim.h)
+   - independent replications can be run in parallel on a thread pool,
+   each with its own random streams, and summarised as means with
+   confidence intervals (see runner.h)
+   - the latency of every message from its layer 5 arrival to its delivery
+   is recorded in a log-bucketed histogram (see hist.h) and reported as
+   percentiles
+   - optional time series of the running counters, sampled every so
+   many time units into a preallocated ring (see sampler.h)
+   - results can be written as JSON or CSV records (see report.h)
+   - a run can be snapshotted, to memory or to a file, and any number of
+   runs forked from the snapshot with their own parameters (see sim.h)
+   - optional bottleneck link in each direction, with a bit rate,
+   propagation delay and drop-tail buffer in packets or bytes, instead
+   of the 1 to 10 time unit channel delay
+   - Gilbert-Elliott bursty loss, and bounded reordering and duplication
+   of packets in either or both directions
+   - replay of recorded path behaviour, per packet loss, corruption and
+   delay from memory mapped trace files (pathtrace.h)
+   - any number of flows, A and B pairs each with their own protocol
+   state, timers and latency queues, sharing the channel
+   - bidirectional transfer is chosen at run time (-bidirectional)
+   rather than compiled in
+   - messages carry a length and up to MAXPAYLOAD bytes, fixed or drawn
+   per message; events are sized for the run's largest payload and
+   packets are copied only as far as their length
+   - the layer 5 arrival process is chosen at run time: the original
+   uniform spacing, Poisson, heavy-tailed on/off bursts, a saturated
+   sender that fills its window whenever it opens, or a replayed
+   arrival log (arrivals.h)
+   - optional stopping rule: a run stops offering messages once batch
+   means of its throughput and latency, less an MSER warm-up, give
+   confidence intervals within a target (batch.h)
+   - the protocol is chosen at run time (-protocol) from those linked in,
+   Selective Repeat, Go Back N and stop-and-wait, and called through a
+   table of its entry points (protocol.h); run under a protocol's name
+   the binary defaults to that protocol
+
+   ********************************************************************* */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "emulator.h"
+#include "protocol.h"
+#include "trace.h"
+#include "bintrace.h"
+#include "hist.h"
+#include "sampler.h"
+#include "pathtrace.h"
+#include "arrivals.h"
+#include "batch.h"
+#include "config.h"
+#include "sim.h"
+#include "runner.h"
+#include "sweep.h"
+#include "report.h"
+
+struct event {
+  float evtime;           /* event time */
+  int evtype;             /* event type code */
+  int eventity;           /* entity where event occurs */
+  int flow;               /* flow the entity belongs to */
+  int corrupted;          /* packet was corrupted by the medium */
+  long evseq;             /* insertion order, used to break ties on evtime */
+  int heapidx;            /* position of this event in evheap */
+  struct pkt pkt;         /* packet (if any) assoc w/ this event, last so */
+};                        /* only the run's payload size is allocated; a */
+                          /* FROM_LAYER5 event keeps its message size in */
+                          /* pkt.length, 0 for the configured one */
+
+/* possible events: */
+#define  TIMER_INTERRUPT 0  
+#define  FROM_LAYER5     1
+#define  FROM_LAYER3     2
+
+#define  OFF             0
+#define  ON              1
+
+/* a free-list pool of fixed size objects, carved out of malloc'd slabs */
+#define POOLSLAB 256      /* objects allocated per slab */
+
+struct pool {
+  size_t objsize;         /* size of one object, at least a pointer */
+  void *freelist;         /* free objects, chained through their first word */
+  void *slabs;            /* slabs, chained through their first slot */
+  int nslabs;             /* number of slabs allocated */
+  int inuse;              /* objects currently handed out */
+  int highwater;          /* most objects ever handed out at once */
+};
+
+/* random number streams, see jimsrand() */
+#define RNG_ARRIVAL  0    /* message arrival times and their entity */
+#define RNG_LOSS     1    /* packet loss */
+#define RNG_CORRUPT  2    /* packet corruption and what gets corrupted */
+#define RNG_DELAY    3    /* channel delay */
+#define RNG_IMPAIR   4    /* reordering and duplication */
+#define RNG_SIZE     5    /* message sizes */
+#define RNG_BURST    6    /* on and off period lengths */
+#define NRNG         7
+
+/* the layer 5 arrival processes, see -workload */
+#define WL_UNIFORM   0    /* spacing uniform on [0, 2*lambda], the original */
+#define WL_POISSON   1    /* exponential spacing with mean lambda */
+#define WL_ONOFF     2    /* Poisson while on, nothing while off */
+#define WL_SATURATED 3    /* always a message waiting for the window */
+#define WL_TRACE     4    /* replayed from an arrival log */
+static const char *workloads[] = { "uniform", "poisson", "onoff", "saturated", "trace" };
+#define NWORKLOADS ((int)(sizeof(workloads) / sizeof(workloads[0])))
+
+struct rng {
+  unsigned long s[4];     /* generator state, 32 bits per word */
+};
+
+/* the bottleneck link towards one entity, used when cfg.bitrate > 0 */
+struct link {
+  float busy;             /* when the packets it holds will all have been sent */
+  int qhead, qcount;      /* ring of the departure times of the packets it */
+  float qdep[LINKQMAX];   /* holds, kept when the buffer is counted in packets */
+};
+
+/* size of a packet on the link, its header and the payload in use */
+#define PKTBYTES(p) ((int)offsetof(struct pkt, payload) + (p)->length)
+
+/* layer 5 arrival times of the messages one side of a flow has accepted
+   and not yet had delivered, oldest first */
+struct subq {
+  float *times;           /* ring of cap entries */
+  int head, count, cap;
+};
+
+/* what the emulator keeps for each flow, one A and B pair.  All flows
+   share the channel, its links and its random streams. */
+struct flow {
+  struct event *timers[2];  /* pending TIMER_INTERRUPT of A and B, NULL if not running */
+  struct subq sub[2];       /* messages accepted by A and by B */
+  int delivered;            /* messages of the flow delivered to layer 5 */
+  int blocked[2];           /* saturated A or B waits for its window to open */
+};
+
+/* one simulation run: everything the emulator and protocol know */
+struct sim {
+  struct simconfig cfg;   /* parameters of the run */
+
+  /* the event list, kept as a binary min-heap ordered by evtime */
+  struct event **evheap;
+  int evcount;            /* number of events in the heap */
+  int evcapacity;         /* allocated slots in evheap */
+  long evseqnext;         /* insertion counter for evseq */
+  struct pool evpool;     /* where events come from */
+  size_t eventsize;       /* bytes of an event, see eventsize() */
+  const struct protocol *proto;  /* the protocol the flows run, see protocol.h */
+
+  struct flow *flows;     /* nflows of them */
+  int nflows;
+  int flow;               /* the flow whose event is being handled */
+
+  /* latest FROM_LAYER3 arrival time scheduled towards A and B */
+  float chantail[2];
+  struct link links[2];   /* bottleneck links towards A and B */
+  int gilbert;            /* Gilbert-Elliott rather than Bernoulli loss */
+  int lossbad[2];         /* the loss model towards A and B is in its bad state */
+  struct pathtrace *paths[2];  /* path traces replayed towards A and B, or NULL */
+  long pathnext[2];       /* their next records */
+
+  int workload;           /* WL_*, the layer 5 arrival process */
+  double burstend;        /* on/off: when the current on period ends */
+  struct arrivals *arrivals;  /* trace: the arrival log, see arrivals.h */
+  long arrivalnext;       /* its next message */
+
+  struct rng rngs[NRNG];  /* one generator per random stream */
+
+  int nsim;               /* number of messages from 5 to 4 so far */
+  float time;
+
+  /* statistics updated by emulator */
+  int ntolayer3;          /* number sent into layer 3 */
+  int nlost;              /* number lost in media */
+  int ncorrupt;           /* number corrupted by media*/
+  int nqdrop;             /* number dropped by a full link buffer */
+  int nreorder;           /* number held back so later packets overtake them */
+  int nduplicate;         /* number delivered twice */
+  int messages_delivered;
+  long bytes_delivered;   /* payload bytes delivered to layer 5 */
+  int inflight;           /* packets in the medium, i.e. FROM_LAYER3 events */
+
+  /* statistics updated by the protocol */
+  struct protostats stats;
+
+  struct hist latency;    /* arrival to delivery time of each message */
+
+  /* the stopping rule, see -stopci */
+  struct batchmeans bmtput;   /* messages delivered per time unit in each batch */
+  struct batchmeans bmlat;    /* mean latency in each batch that delivered any */
+  double nextbatch;       /* end of the current batch */
+  int batchdelivered;     /* messages_delivered when it began */
+  long batchlatcount;     /* and latency.count and latency.sum */
+  double batchlatsum;
+  int stopped;            /* converged, no more messages are offered */
+
+  void *state;            /* protocol state, statestride bytes per flow */
+  size_t statestride;
+  struct bintrace *bt;    /* binary event trace, NULL if not recording */
+  struct sampler *sp;     /* time series sampler, NULL if not sampling */
+  double nextsample;      /* time of the next sample */
+};
+
+int TRACE = 3;
+
+/****************************************************************************/
+/* jimsrand(): return a double in range [0,1).  The routine below is used to */
+/* isolate all random number generation in one location.  Every source of    */
+/* randomness draws from its own stream, so that e.g. changing the loss rate */
+/* does not move the arrival times, and runs of different protocols see the  */
+/* same random numbers.  The generator is xoshiro128** (Blackman & Vigna),   */
+/* kept in unsigned longs masked to 32 bits so it is portable ANSI C.        */
+/****************************************************************************/
+#define MASK32(x)    ((x) & 0xffffffffUL)
+#define ROTL32(x, k) MASK32(((x) << (k)) | ((x) >> (32 - (k))))
+
+static unsigned long rngnext(struct rng *r)
+{
+  unsigned long *s = r->s;
+  unsigned long result = MASK32(ROTL32(MASK32(s[1] * 5), 7) * 9);
+  unsigned long t = MASK32(s[1] << 9);
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = ROTL32(s[3], 11);
+  return result;
+}  
+
+/* jump polynomials advancing the generator by 2^64 and 2^96 draws */
+static const unsigned long rngjump64[4] =
+  { 0x8764000bUL, 0xf542d2d3UL, 0x6fa035c3UL, 0x77f2db5bUL };
+static const unsigned long rngjump96[4] =
+  { 0xb523952eUL, 0x0b6f099fUL, 0xccf5a0efUL, 0x1c580662UL };
+
+/* advance r as far as the jump polynomial says, giving a stream that
+   does not overlap the draws skipped */
+static void rngjump(struct rng *r, const unsigned long *jump)
+{
+  unsigned long s[4] = { 0, 0, 0, 0 };
+  int i, b, k;
+
+  for (i = 0; i < 4; i++)
+    for (b = 0; b < 32; b++) {
+      if (jump[i] & (1UL << b))
+        for (k = 0; k < 4; k++)
+          s[k] ^= r->s[k];
+      rngnext(r);
+    }
+  for (k = 0; k < 4; k++)
+    r->s[k] = s[k];
+}  
+
+/* splitmix32, used to spread a seed over the generator state */
+static unsigned long splitmix32(unsigned long *x)
+{
+  unsigned long z;
+
+  *x = MASK32(*x + 0x9e3779b9UL);
+  z = *x;
+  z = MASK32((z ^ (z >> 16)) * 0x85ebca6bUL);
+  z = MASK32((z ^ (z >> 13)) * 0xc2b2ae35UL);
+  return z ^ (z >> 16);
+}  
+
+/* seed every stream.  Replication r starts 2^96 * r draws into the
+   seeded generator and its stream i a further 2^64 * i draws in, so no
+   streams of any two replications overlap. */
+static void rnginit(struct sim *sim, unsigned long seedval, int replica)
+{
+  unsigned long x = MASK32(seedval);
+  int i, k;
+
+  for (k = 0; k < 4; k++)
+    sim->rngs[0].s[k] = splitmix32(&x);
+  for (i = 0; i < replica; i++)
+    rngjump(&sim->rngs[0], rngjump96);
+  for (i = 1; i < NRNG; i++) {
+    sim->rngs[i] = sim->rngs[i - 1];
+    rngjump(&sim->rngs[i], rngjump64);
+  }  
+}  
+
+double jimsrand(struct sim *sim, int stream)
+{
+  double x;                   
+  x = rngnext(&sim->rngs[stream]) / 4294967296.0;  /* x is uniform in [0,1) */
+  TRACEF(4, ("RANDOM NUMBER GENERAION CALLED: %f\n", x));
+  return(x);
+}  
+
+/********************* EVENT HANDLINE ROUTINES *******/
+/*  The next set of routines handle the event list   */
+/*****************************************************/
+
+/* does event p have to be simulated before event q?  Events with equal
+   times are taken most recently inserted first, which is the order the
+   original sorted list produced, so traces are unchanged. */
+static int evbefore(struct event *p, struct event *q)
+{
+  if (p->evtime != q->evtime)
+    return p->evtime < q->evtime;
+  return p->evseq > q->evseq;
+}  
+
+static void evplace(struct sim *sim, struct event *p, int i)
+{
+  sim->evheap[i] = p;
+  p->heapidx = i;
+}  
+
+/* move the event at slot i towards the root until the heap is ordered */
+static void evsiftup(struct sim *sim, int i)
+{
+  struct event *p = sim->evheap[i];
+  int parent;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (!evbefore(p, sim->evheap[parent]))
+      break;
+    evplace(sim, sim->evheap[parent], i);
+    i = parent;
+  }  
+  evplace(sim, p, i);
+}  
+
+/* move the event at slot i towards the leaves until the heap is ordered */
+static void evsiftdown(struct sim *sim, int i)
+{
+  struct event *p = sim->evheap[i];
+  int child;
+
+  while ((child = 2 * i + 1) < sim->evcount) {
+    if (child + 1 < sim->evcount && evbefore(sim->evheap[child + 1], sim->evheap[child]))
+      child++;
+    if (!evbefore(sim->evheap[child], p))
+      break;
+    evplace(sim, sim->evheap[child], i);
+    i = child;
+  }  
+  evplace(sim, p, i);
+}  
+
+void insertevent(struct sim *sim, struct event *p)
+{
+  TRACEF(3, ("            INSERTEVENT: time is %f\n            INSERTEVENT: future time will be %f\n",
+              sim->time, p->evtime));
+  if (sim->evcount == sim->evcapacity) {   /* heap is full, double its size */
+    sim->evcapacity = (sim->evcapacity == 0) ? 64 : 2 * sim->evcapacity;
+    sim->evheap = realloc(sim->evheap, sim->evcapacity * sizeof(struct event *));
+    if (sim->evheap == 0) {
+      printf("memory allocation for event list failed.");
+      exit(EXIT_FAILURE);
+    }
+  }  
+  p->evseq = sim->evseqnext++;
+  sim->evheap[sim->evcount++] = p;
+  evsiftup(sim, sim->evcount - 1);
+}  
+
+/* remove an event from anywhere in the event list */
+void removeevent(struct sim *sim, struct event *p)
+{
+  int i = p->heapidx;
+
+  sim->evcount--;
+  if (i == sim->evcount)        /* last slot, nothing to reorder */
+    return;
+  evplace(sim, sim->evheap[sim->evcount], i);
+  if (i > 0 && evbefore(sim->evheap[i], sim->evheap[(i - 1) / 2]))
+    evsiftup(sim, i);
+  else
+    evsiftdown(sim, i);
+}  
+
+/* remove and return the next event to simulate, NULL if there are none */
+struct event *popevent(struct sim *sim)
+{
+  struct event *p;
+
+  if (sim->evcount == 0)
+    return NULL;
+  p = sim->evheap[0];
+  removeevent(sim, p);
+  return p;
+}  
+
+/******************** MEMORY POOLS ******************/
+/*  Events and packet copies are recycled through   */
+/*  free lists rather than returned to malloc()     */
+/*****************************************************/
+
+static void poolinit(struct pool *pl, size_t objsize)
+{
+  pl->objsize = objsize;
+  pl->freelist = NULL;
+  pl->slabs = NULL;
+  pl->nslabs = 0;
+  pl->inuse = 0;
+  pl->highwater = 0;
+}  
+
+static void *poolget(struct pool *pl)
+{
+  char *slab;
+  void *obj;
+  int i;
+
+  if (pl->freelist == NULL) {   /* no free objects, carve a new slab */
+    slab = malloc(pl->objsize * (POOLSLAB + 1));
+    if (slab == 0) {
+      printf("memory allocation for pool failed.");
+      exit(EXIT_FAILURE);
+    }
+    *(void **)slab = pl->slabs;   /* slot 0 links the slabs together */
+    pl->slabs = slab;
+    pl->nslabs++;
+    for (i = POOLSLAB; i >= 1; i--) {
+      obj = slab + i * pl->objsize;
+      *(void **)obj = pl->freelist;
+      pl->freelist = obj;
+    }
+  }  
+  obj = pl->freelist;
+  pl->freelist = *(void **)obj;
+  if (++pl->inuse > pl->highwater)
+    pl->highwater = pl->inuse;
+  return obj;
+}  
+
+static void poolput(struct pool *pl, void *obj)
+{
+  *(void **)obj = pl->freelist;
+  pl->freelist = obj;
+  pl->inuse--;
+}  
+
+/* give every slab back to malloc */
+static void poolfree(struct pool *pl)
+{
+  void *slab;
+
+  while ((slab = pl->slabs) != NULL) {
+    pl->slabs = *(void **)slab;
+    free(slab);
+  }  
+  pl->freelist = NULL;
+  pl->nslabs = 0;
+  pl->inuse = 0;
+}  
+
+/******************** ARRIVAL PROCESSES *******************/
+/*  Each one gives the time to the next layer 5 arrival.    */
+/*  A saturated sender has no arrivals of its own, see      */
+/*  feed().                                                 */
+/************************************************************/
+
+/* exponential with mean lambda, the spacing of Poisson arrivals */
+static double expspacing(struct sim *sim)
+{
+  return -sim->cfg.lambda * log(1.0 - jimsrand(sim, RNG_ARRIVAL));
+}  
+
+/* Pareto with the given mean and shape -burstshape, for period lengths
+   whose variance is infinite when the shape is 2 or less */
+static double pareto(struct sim *sim, double mean)
+{
+  double shape = sim->cfg.burstshape;
+
+  return mean * (shape - 1) / shape / pow(1.0 - jimsrand(sim, RNG_BURST), 1 / shape);
+}  
+
+/* on/off: Poisson arrivals while on, none while off.  Arrivals are
+   memoryless, so one that would land after the on period ends is
+   drawn again from the start of the next one. */
+static double onoff(struct sim *sim)
+{
+  double t = sim->time + expspacing(sim);
+  double on;
+
+  while (t > sim->burstend) {
+    on = sim->burstend + pareto(sim, sim->cfg.offmean);
+    sim->burstend = on + pareto(sim, sim->cfg.onmean);
+    t = on + expspacing(sim);
+  }  
+  return t - sim->time;
+}  
+
+void generate_next_arrival(struct sim *sim)
+{
+  double x;                   
+  struct event *evptr;
+  int size = 0;
+
+  TRACEF(3, ("          GENERATE NEXT ARRIVAL: creating new arrival\n"));
+
+  switch (sim->workload) {
+  case WL_POISSON:
+    x = expspacing(sim);
+    break;
+  case WL_ONOFF:
+    x = onoff(sim);
+    break;
+  case WL_SATURATED:
+    return;
+  case WL_TRACE:
+    if (sim->arrivalnext >= arrivals_length(sim->arrivals))
+      return;                     /* the whole log has been replayed */
+    x = arrivals_time(sim->arrivals, sim->arrivalnext) - sim->time;
+    if (x < 0.0)                  /* behind a fork's snapshot time */
+      x = 0.0;
+    size = arrivals_size(sim->arrivals, sim->arrivalnext++);
+    break;
+  default:
+    x = sim->cfg.lambda*jimsrand(sim, RNG_ARRIVAL)*2;  /* x is uniform on [0,2*lambda] */
+    /* having mean of lambda        */
+    break;
+  }  
+  evptr = poolget(&sim->evpool);
+  evptr->evtime =  sim->time + x;
+  evptr->evtype =  FROM_LAYER5;
+  evptr->pkt.length = size;
+  if (sim->cfg.bidirectional && (jimsrand(sim, RNG_ARRIVAL)>0.5) )
+    evptr->eventity = B;
+  else
+    evptr->eventity = A;
+  /* messages are spread evenly over the flows */
+  evptr->flow = (sim->nflows > 1) ? (int)(jimsrand(sim, RNG_ARRIVAL) * sim->nflows) : 0;
+  insertevent(sim, evptr);
+}  
+
+void printevlist(struct sim *sim)
+{
+  struct event *q;
+  int i;
+  printf("--------------\nEvent List Follows (heap order):\n");
+  for (i = 0; i < sim->evcount; i++) {
+    q = sim->evheap[i];
+    printf("Event time: %f, type: %d entity: %d\n",q->evtime,q->evtype,q->eventity);
+  }  
+  printf("--------------\n");
+}  
+
+/* start the binary trace and sampler the configuration asks for */
+static void openrecorders(struct sim *sim)
+{
+  if (sim->cfg.bintrace[0] != '\0')
+    sim->bt = bintrace_open(sim->cfg.bintrace, sim->cfg.bintracerecs);
+  if (sim->cfg.samplefile[0] != '\0') {
+    sim->sp = sampler_open(sim->cfg.samplefile, sim->cfg.samplerecs);
+    /* the first sample time after now */
+    sim->nextsample = (floor(sim->time / sim->cfg.sampleinterval) + 1) * sim->cfg.sampleinterval;
+  }  
+}  
+
+/* map the path traces to replay; a forked run carries on from the
+   records its snapshot had reached */
+static void openpaths(struct sim *sim)
+{
+  const char *path[2];
+  int k;
+
+  path[A] = sim->cfg.pathba;
+  path[B] = sim->cfg.pathab;
+  for (k = A; k <= B; k++) {
+    sim->paths[k] = NULL;
+    if (path[k][0] == '\0')
+      continue;
+    sim->paths[k] = pathtrace_open(path[k]);
+    if (sim->paths[k] == NULL)
+      exit(EXIT_FAILURE);
+    sim->pathnext[k] %= pathtrace_length(sim->paths[k]);
+  }  
+}  
+
+/* set up the arrival process the configuration asks for; a forked run
+   carries on through the arrival log from where its snapshot was */
+static void openworkload(struct sim *sim)
+{
+  for (sim->workload = 0; sim->workload < NWORKLOADS - 1; sim->workload++)
+    if (strcmp(sim->cfg.workload, workloads[sim->workload]) == 0)
+      break;
+  sim->arrivals = NULL;
+  if (sim->workload == WL_TRACE) {
+    sim->arrivals = arrivals_load(sim->cfg.arrivals, sim->cfg.payload);
+    if (sim->arrivals == NULL)
+      exit(EXIT_FAILURE);
+  }  
+}  
+
+/* a saturated sender starts with a message waiting at A of every flow,
+   and at B too with bidirectional transfer */
+static void saturate(struct sim *sim)
+{
+  struct event *evptr;
+  int f, e;
+
+  for (f = 0; f < sim->nflows; f++)
+    for (e = A; e <= (sim->cfg.bidirectional ? B : A); e++) {
+      evptr = poolget(&sim->evpool);
+      evptr->evtime = sim->time;
+      evptr->evtype = FROM_LAYER5;
+      evptr->eventity = e;
+      evptr->flow = f;
+      evptr->pkt.length = 0;
+      insertevent(sim, evptr);
+    }  
+}  
+
+/* bytes of an event carrying a packet with the run's largest payload,
+   rounded up so the events of a pool slab stay aligned */
+static size_t eventsize(const struct simconfig *cfg)
+{
+  size_t size = offsetof(struct event, pkt) + PKTSIZE(cfg->payload);
+
+  return (size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+}  
+
+/* bytes of protocol state per flow, rounded up so each flow's block is
+   aligned like the first */
+static size_t statestride(const struct simconfig *cfg)
+{
+  return (protocol_statesize(cfg) + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+}  
+
+/* allocate the flows, with no timers running and no messages queued */
+static struct flow *newflows(int nflows)
+{
+  struct flow *flows;
+  int f, k;
+
+  flows = malloc(nflows * sizeof(struct flow));
+  if (flows == NULL)
+    return NULL;
+  for (f = 0; f < nflows; f++) {
+    for (k = A; k <= B; k++) {
+      flows[f].timers[k] = NULL;
+      flows[f].sub[k].times = NULL;
+      flows[f].sub[k].head = flows[f].sub[k].count = flows[f].sub[k].cap = 0;
+    }  
+    flows[f].delivered = 0;
+    flows[f].blocked[A] = flows[f].blocked[B] = 0;
+  }  
+  return flows;
+}  
+
+struct sim *sim_create(const struct simconfig *cfg)   /* initialize the simulator */
+{
+  struct sim *sim;
+  int f;
+
+  sim = calloc(1, sizeof(struct sim));
+  if (sim != NULL) {
+    sim->nflows = cfg->flows;
+    sim->statestride = statestride(cfg);
+    sim->state = calloc(sim->nflows, sim->statestride);
+    sim->flows = newflows(sim->nflows);
+  }  
+  if (sim == NULL || sim->state == NULL || sim->flows == NULL) {
+    printf("memory allocation for simulation failed.");
+    exit(EXIT_FAILURE);
+  }  
+  sim->cfg = *cfg;
+  sim->proto = protocol_find(cfg->protocol);
+  sim->gilbert = (strcmp(cfg->lossmodel, "gilbert") == 0);
+  sim->eventsize = eventsize(cfg);
+  poolinit(&sim->evpool, sim->eventsize);
+
+  rnginit(sim, cfg->seed, cfg->replica);   /* init random number generator */
+
+  /* statistics and the event list start out zeroed by calloc() */
+  sim->time=0.0;                    /* initialize time to 0.0 */
+  sim->chantail[A] = sim->chantail[B] = 0.0;
+  sim->nextbatch = cfg->batchtime;
+
+  openrecorders(sim);
+  openpaths(sim);
+  openworkload(sim);
+  if (sim->workload == WL_ONOFF)  /* starting with an on period */
+    sim->burstend = pareto(sim, cfg->onmean);
+
+  if (sim->workload == WL_SATURATED)
+    saturate(sim);
+  else
+    generate_next_arrival(sim);     /* initialize event list */
+  for (f = 0; f < sim->nflows; f++) {
+    sim->flow = f;
+    sim->proto->A_init(sim);
+    sim->proto->B_init(sim);
+  }  
+  return sim;
+}  
+
+void sim_destroy(struct sim *sim)
+{
+  int f;
+
+  if (sim->bt != NULL)
+    bintrace_close(sim->bt);
+  if (sim->sp != NULL)
+    sampler_close(sim->sp);
+  if (sim->paths[A] != NULL)
+    pathtrace_close(sim->paths[A]);
+  if (sim->paths[B] != NULL)
+    pathtrace_close(sim->paths[B]);
+  if (sim->arrivals != NULL)
+    arrivals_free(sim->arrivals);
+  batch_free(&sim->bmtput);
+  batch_free(&sim->bmlat);
+  poolfree(&sim->evpool);
+  free(sim->evheap);
+  for (f = 0; f < sim->nflows; f++) {
+    free(sim->flows[f].sub[A].times);
+    free(sim->flows[f].sub[B].times);
+  }  
+  free(sim->flows);
+  free(sim->state);
+  free(sim);
+}  
+
+/********************* MESSAGE LATENCY ROUTINES *****************************/
+/* Both protocols hand messages to layer 5 in the order they accepted them, */
+/* so the arrival time of each accepted message is queued and the oldest    */
+/* one is taken when a message is delivered.  Each side of each flow has    */
+/* its own queue.                                                           */
+/****************************************************************************/
+
+/* entity AorB of the current flow accepted a message that arrived from
+   layer 5 now */
+static void msgaccepted(struct sim *sim, int AorB)
+{
+  struct subq *q = &sim->flows[sim->flow].sub[AorB];
+  float *grown;
+  int i, cap;
+
+  if (q->count == q->cap) {
+    cap = q->cap > 0 ? 2 * q->cap : 64;
+    grown = malloc(cap * sizeof(float));
+    if (grown == NULL) {
+      printf("memory allocation for latencies failed.");
+      exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < q->count; i++)
+      grown[i] = q->times[(q->head + i) % q->cap];
+    free(q->times);
+    q->times = grown;
+    q->head = 0;
+    q->cap = cap;
+  }  
+  q->times[(q->head + q->count) % q->cap] = sim->time;
+  q->count++;
+}  
+
+/* a message sent by entity AorB of the current flow has been delivered now */
+static void msgdelivered(struct sim *sim, int AorB)
+{
+  struct subq *q = &sim->flows[sim->flow].sub[AorB];
+
+  if (q->count == 0) {
+    TRACEF(0, ("Warning: delivered a message that was never accepted\n"));
+    return;
+  }  
+  hist_record(&sim->latency, sim->time - q->times[q->head]);
+  q->head = (q->head + 1) % q->cap;
+  q->count--;
+}  
+
+/************************** SNAPSHOTS ******************************/
+/* A snapshot is one malloc'd block, so it can be written to disk and  */
+/* read back as is: a struct snapshot holding a copy of the struct sim */
+/* with its pointers cleared, followed by the events in heap order     */
+/* (eventsize bytes apart, so packets are only as big as the run's     */
+/* payload), a struct flowsnap per flow, the queued layer 5 arrival    */
+/* times of A then B of each flow in turn, the protocol state of every */
+/* flow (which holds no pointers, see sr.c and gbn.c) and the batch    */
+/* means of throughput then latency.  The timers are not               */
+/* kept, they are the TIMER_INTERRUPT events.  Every section           */
+/* starts on a SNAPALIGN boundary.  The format is only meant to be     */
+/* read back by the same build on the same kind of machine.            */
+/***********************************************************************/
+
+#define SNAP_MAGIC "RTSNAP1"     /* 7 characters plus the terminator */
+#define SNAPALIGN  sizeof(double)
+#define SNAPROUND(n) (((n) + SNAPALIGN - 1) / SNAPALIGN * SNAPALIGN)
+
+struct snapshot {
+  char magic[8];          /* SNAP_MAGIC */
+  long size;              /* bytes in the whole snapshot */
+  long simsize;           /* sizeof(struct sim) when taken */
+  long eventsize;         /* bytes of each event, see eventsize() */
+  long statesize;         /* protocol state bytes, all flows */
+  long nsubtimes;         /* queued layer 5 arrival times, all flows */
+  int nevents;            /* events in the heap */
+  struct sim sim;
+};
+
+/* the emulator's per flow state, less its pointers */
+struct flowsnap {
+  int subcount[2];        /* queued arrival times of A and B */
+  int delivered;
+  int blocked[2];
+};
+
+/* where the sections after the header start */
+#define SNAPEVENTS(sn) ((char *)(sn) + SNAPROUND(sizeof(struct snapshot)))
+#define SNAPEVENT(sn, i) ((struct event *)(SNAPEVENTS(sn) + (i) * (sn)->eventsize))
+#define SNAPFLOWS(sn) ((struct flowsnap *)(SNAPEVENTS(sn) \
+                       + SNAPROUND((sn)->nevents * (sn)->eventsize)))
+#define SNAPSUBTIMES(sn) ((float *)((char *)SNAPFLOWS(sn) \
+                          + SNAPROUND((sn)->sim.nflows * sizeof(struct flowsnap))))
+#define SNAPSTATE(sn) ((char *)SNAPSUBTIMES(sn) + SNAPROUND((sn)->nsubtimes * sizeof(float)))
+#define SNAPBATCHES(sn) ((double *)(SNAPSTATE(sn) + SNAPROUND((sn)->statesize)))
+
+struct snapshot *sim_snapshot(struct sim *sim)
+{
+  struct snapshot *sn;
+  struct subq *q;
+  float *sub;
+  long size, nsub = 0;
+  int i, f, k;
+
+  for (f = 0; f < sim->nflows; f++)
+    nsub += sim->flows[f].sub[A].count + sim->flows[f].sub[B].count;
+  size = SNAPROUND(sizeof(struct snapshot))
+    + SNAPROUND(sim->evcount * sim->eventsize)
+    + SNAPROUND(sim->nflows * sizeof(struct flowsnap))
+    + SNAPROUND(nsub * sizeof(float))
+    + SNAPROUND(sim->nflows * sim->statestride)
+    + SNAPROUND((sim->bmtput.n + sim->bmlat.n) * sizeof(double));
+  sn = calloc(1, size);
+  if (sn == NULL) {
+    printf("memory allocation for snapshot failed.");
+    exit(EXIT_FAILURE);
+  }  
+  strcpy(sn->magic, SNAP_MAGIC);
+  sn->size = size;
+  sn->simsize = sizeof(struct sim);
+  sn->eventsize = sim->eventsize;
+  sn->statesize = sim->nflows * sim->statestride;
+  sn->nsubtimes = nsub;
+  sn->nevents = sim->evcount;
+
+  sn->sim = *sim;
+  memset(&sn->sim.evpool, 0, sizeof(sn->sim.evpool));
+  sn->sim.evpool.highwater = sim->evpool.highwater;
+  sn->sim.evheap = NULL;
+  sn->sim.evcapacity = 0;
+  sn->sim.flows = NULL;
+  sn->sim.state = NULL;
+  sn->sim.bt = NULL;
+  sn->sim.sp = NULL;
+  sn->sim.arrivals = NULL;
+  sn->sim.proto = NULL;
+  sn->sim.bmtput.x = sn->sim.bmlat.x = NULL;
+  sn->sim.bmtput.cap = sn->sim.bmlat.cap = 0;
+
+  for (i = 0; i < sim->evcount; i++)
+    memcpy(SNAPEVENT(sn, i), sim->evheap[i], sim->eventsize);
+  sub = SNAPSUBTIMES(sn);
+  for (f = 0; f < sim->nflows; f++) {
+    for (k = A; k <= B; k++) {
+      q = &sim->flows[f].sub[k];
+      SNAPFLOWS(sn)[f].subcount[k] = q->count;
+      for (i = 0; i < q->count; i++)
+        *sub++ = q->times[(q->head + i) % q->cap];
+    }  
+    SNAPFLOWS(sn)[f].delivered = sim->flows[f].delivered;
+    SNAPFLOWS(sn)[f].blocked[A] = sim->flows[f].blocked[A];
+    SNAPFLOWS(sn)[f].blocked[B] = sim->flows[f].blocked[B];
+  }  
+  memcpy(SNAPSTATE(sn), sim->state, sn->statesize);
+  if (sim->bmtput.n > 0)
+    memcpy(SNAPBATCHES(sn), sim->bmtput.x, sim->bmtput.n * sizeof(double));
+  if (sim->bmlat.n > 0)
+    memcpy(SNAPBATCHES(sn) + sim->bmtput.n, sim->bmlat.x, sim->bmlat.n * sizeof(double));
+  return sn;
+}  
+
+const struct simconfig *snapshot_config(const struct snapshot *sn)
+{
+  return &sn->sim.cfg;
+}  
+
+int sim_forkable(const struct simconfig *from, const struct simconfig *to, char *changed)
+{
+  char names[SIM_FORKNAMES];
+
+  names[0] = '\0';
+  if (strcmp(from->protocol, to->protocol) != 0)
+    strcat(names, " protocol");
+  if (from->flows != to->flows)
+    strcat(names, " flows");
+  if (from->windowsize != to->windowsize)
+    strcat(names, " window");
+  if (from->seqspace != to->seqspace)
+    strcat(names, " seqspace");
+  if (from->payload != to->payload)
+    strcat(names, " payload");
+  if (from->bidirectional != to->bidirectional)
+    strcat(names, " bidirectional");
+  if (from->ackdelay != to->ackdelay)
+    strcat(names, " ackdelay");
+  if ((strcmp(from->workload, "saturated") == 0) != (strcmp(to->workload, "saturated") == 0))
+    strcat(names, " workload(saturated)");
+  if (changed != NULL)
+    strcpy(changed, names[0] != '\0' ? names + 1 : names);
+  return names[0] == '\0';
+}  
+
+struct sim *sim_fork(const struct snapshot *sn, const struct simconfig *cfg)
+{
+  struct sim *sim;
+  struct event *p;
+  const float *sub;
+  char changed[SIM_FORKNAMES];
+  int i, f, k;
+
+  if (!sim_forkable(&sn->sim.cfg, cfg, changed)) {
+    fprintf(stderr, "a branch cannot change %s\n", changed);
+    return NULL;
+  }  
+  sim = malloc(sizeof(struct sim));
+  if (sim != NULL) {
+    *sim = sn->sim;
+    sim->state = malloc(sn->statesize);
+    sim->flows = newflows(sim->nflows);
+    sim->evcapacity = sn->nevents > 64 ? sn->nevents : 64;
+    sim->evheap = malloc(sim->evcapacity * sizeof(struct event *));
+  }  
+  if (sim == NULL || sim->state == NULL || sim->flows == NULL || sim->evheap == NULL) {
+    printf("memory allocation for simulation failed.");
+    exit(EXIT_FAILURE);
+  }  
+  sim->cfg = *cfg;
+  sim->proto = protocol_find(cfg->protocol);
+  sim->gilbert = (strcmp(cfg->lossmodel, "gilbert") == 0);
+  memcpy(sim->state, SNAPSTATE(sn), sn->statesize);
+  batch_init(&sim->bmtput);
+  batch_init(&sim->bmlat);
+  for (i = 0; i < sn->sim.bmtput.n; i++)
+    batch_add(&sim->bmtput, SNAPBATCHES(sn)[i]);
+  for (i = 0; i < sn->sim.bmlat.n; i++)
+    batch_add(&sim->bmlat, SNAPBATCHES(sn)[sn->sim.bmtput.n + i]);
+
+  /* the events keep their slots and insertion numbers, so the heap is
+     ordered and ties break as they would have */
+  poolinit(&sim->evpool, sim->eventsize);
+  for (i = 0; i < sn->nevents; i++) {
+    p = poolget(&sim->evpool);
+    memcpy(p, SNAPEVENT(sn, i), sim->eventsize);
+    evplace(sim, p, i);
+    if (p->evtype == TIMER_INTERRUPT)
+      sim->flows[p->flow].timers[p->eventity] = p;
+  }  
+  sim->evpool.highwater = sn->sim.evpool.highwater;
+
+  sub = SNAPSUBTIMES(sn);
+  for (f = 0; f < sim->nflows; f++) {
+    sim->flow = f;
+    for (k = A; k <= B; k++)
+      for (i = 0; i < SNAPFLOWS(sn)[f].subcount[k]; i++) {
+        sim->time = *sub++;       /* msgaccepted() queues the time now */
+        msgaccepted(sim, k);
+      }  
+    sim->flows[f].delivered = SNAPFLOWS(sn)[f].delivered;
+    sim->flows[f].blocked[A] = SNAPFLOWS(sn)[f].blocked[A];
+    sim->flows[f].blocked[B] = SNAPFLOWS(sn)[f].blocked[B];
+  }  
+  sim->flow = sn->sim.flow;
+  sim->time = sn->sim.time;
+
+  sim->bt = NULL;
+  sim->sp = NULL;
+  openrecorders(sim);
+  openpaths(sim);
+  openworkload(sim);
+  return sim;
+}  
+
+int snapshot_save(const struct snapshot *sn, const char *path)
+{
+  FILE *fp;
+
+  fp = fopen(path, "wb");
+  if (fp == NULL) {
+    fprintf(stderr, "unable to open snapshot file %s\n", path);
+    return -1;
+  }  
+  if (fwrite(sn, sn->size, 1, fp) != 1 || fclose(fp) != 0) {
+    fprintf(stderr, "error writing snapshot file %s\n", path);
+    return -1;
+  }  
+  return 0;
+}  
+
+struct snapshot *snapshot_load(const char *path)
+{
+  struct snapshot hdr;
+  struct snapshot *sn;
+  FILE *fp;
+
+  fp = fopen(path, "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "unable to open snapshot file %s\n", path);
+    return NULL;
+  }  
+  if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || memcmp(hdr.magic, SNAP_MAGIC, sizeof(hdr.magic)) != 0
+      || hdr.simsize != (long)sizeof(struct sim) || hdr.eventsize != (long)eventsize(&hdr.sim.cfg)
+      || hdr.statesize != (long)(hdr.sim.nflows * statestride(&hdr.sim.cfg))) {
+    fprintf(stderr, "%s is not a snapshot taken by this program\n", path);
+    fclose(fp);
+    return NULL;
+  }  
+  sn = malloc(hdr.size);
+  if (sn == NULL) {
+    printf("memory allocation for snapshot failed.");
+    exit(EXIT_FAILURE);
+  }  
+  rewind(fp);
+  if (fread(sn, hdr.size, 1, fp) != 1) {
+    fprintf(stderr, "snapshot file %s is truncated\n", path);
+    free(sn);
+    sn = NULL;
+  }  
+  fclose(fp);
+  return sn;
+}  
+
+void snapshot_free(struct snapshot *sn)
+{
+  free(sn);
+}  
+
+/********************** Student-callable ROUTINES ***********************/
+
+struct protostats *sim_stats(struct sim *sim)
+{
+  return &sim->stats;
+}  
+
+double sim_time(struct sim *sim)
+{
+  return sim->time;
+}  
+
+const struct simconfig *sim_config(struct sim *sim)
+{
+  return &sim->cfg;
+}  
+
+void *sim_state(struct sim *sim)
+{
+  return (char *)sim->state + sim->flow * sim->statestride;
+}  
+
+/* called by students routine to cancel a previously-started timer */
+void stoptimer(struct sim *sim, int AorB)
+/* A or B is trying to stop timer */
+{
+  struct event **timer = &sim->flows[sim->flow].timers[AorB];
+  struct event *q;
+
+  TRACEF(2, ("          STOP TIMER: stopping timer at %f\n",sim->time));
+  q = *timer;
+  if (q != NULL) {
+    /* remove this event */
+    removeevent(sim, q);
+    poolput(&sim->evpool, q);
+    *timer = NULL;
+    return;
+  }  
+  TRACEF(0, ("Warning: unable to cancel your timer. It wasn't running.\n"));
+}  
+
+
+void starttimer(struct sim *sim, int AorB, double increment)
+/* A or B is trying to start timer */
+{
+
+  struct event **timer = &sim->flows[sim->flow].timers[AorB];
+  struct event *evptr;
+
+  TRACEF(2, ("          START TIMER: starting timer at %f\n",sim->time));
+  /* be nice: check to see if timer is already started, if so, then  warn */
+  if (*timer != NULL) {
+    TRACEF(0, ("Warning: attempt to start a timer that is already started\n"));
+    return;
+  }  
+
+  /* create future event for when timer goes off */
+  evptr = poolget(&sim->evpool);
+  evptr->evtime =  sim->time + increment;
+  evptr->evtype =  TIMER_INTERRUPT;
+
+
+  evptr->eventity = AorB;
+  evptr->flow = sim->flow;
+  insertevent(sim, evptr);
+  *timer = evptr;
+}  
+
+
+/************************** TOLAYER3 ***************/
+/* queue a packet of the given size on the link towards entity to.
+   Returns the time it has been sent, or a negative time if the buffer
+   is full and the packet is dropped. */
+static double linksend(struct sim *sim, int to, int bytes)
+{
+  struct link *lk = &sim->links[to];
+  double backlog;
+
+  /* packets sent by now have left the buffer */
+  while (lk->qcount > 0 && lk->qdep[lk->qhead] <= sim->time) {
+    lk->qhead = (lk->qhead + 1) % LINKQMAX;
+    lk->qcount--;
+  }  
+  /* bytes still to be sent, the rest of the one on the wire included */
+  backlog = (lk->busy > sim->time) ? (lk->busy - sim->time) * sim->cfg.bitrate / 8 : 0.0;
+  if ((sim->cfg.buffer > 0 && lk->qcount >= sim->cfg.buffer)
+      || (sim->cfg.bufferbytes > 0 && backlog + bytes > sim->cfg.bufferbytes))
+    return -1.0;
+
+  if (lk->busy < sim->time)
+    lk->busy = sim->time;
+  lk->busy += bytes * 8 / sim->cfg.bitrate;   /* serialization delay */
+  if (sim->cfg.buffer > 0) {
+    lk->qdep[(lk->qhead + lk->qcount) % LINKQMAX] = lk->busy;
+    lk->qcount++;
+  }  
+  return lk->busy;
+}  
+
+/* does the medium lose a packet sent by AorB?  hit is whether the loss
+   direction covers it.  Bernoulli loss draws a number for every packet,
+   as the original did, so traces do not change.  Gilbert-Elliott loss
+   first moves the direction between its good state, where packets are
+   lost with lossprob, and its bad state, where they are lost with
+   badloss, so losses come in bursts of mean length 1/togood. */
+static int pktlost(struct sim *sim, int AorB, int hit)
+{
+  int to = (AorB+1) % 2;
+  double lossprob;
+
+  if (!sim->gilbert)
+    return jimsrand(sim, RNG_LOSS) < sim->cfg.lossprob && hit;
+  if (!hit)
+    return 0;
+  if (jimsrand(sim, RNG_LOSS) < (sim->lossbad[to] ? sim->cfg.togood : sim->cfg.tobad)) {
+    sim->lossbad[to] = !sim->lossbad[to];
+    TRACEF(2, ("          TOLAYER3: loss towards %s now in its %s state\n",
+                (to == A) ? "A" : "B", sim->lossbad[to] ? "bad" : "good"));
+  }  
+  lossprob = sim->lossbad[to] ? sim->cfg.badloss : sim->cfg.lossprob;
+  return jimsrand(sim, RNG_LOSS) < lossprob;
+}  
+
+void pkt_copy(struct pkt *to, const struct pkt *from)
+{
+  memcpy(to, from, PKTSIZE(from->length));
+}  
+
+void tolayer3(struct sim *sim, int AorB, const struct pkt *packet)
+/* A or B is sending to network  */
+{
+  struct pkt *mypktptr;
+  struct event *evptr;
+  float lastime, x;
+  struct event *dupptr;
+  const struct ptrec *rec = NULL;
+  int to = (AorB+1) % 2;
+  int fate;
+  int dir = sim->cfg.corruptdirection;
+  int idir = sim->cfg.impairdirection;
+  int impair = (!(AorB == B && idir == A) && !(AorB == A && idir == B));
+  int linked = (sim->cfg.bitrate > 0.0);
+  double sent = 0.0;
+
+  if (packet->length < 0 || packet->length > sim->cfg.payload) {
+    TRACEF(0, ("Warning: packet with a payload of %d bytes not sent, the most is %d\n",
+                packet->length, sim->cfg.payload));
+    return;
+  }  
+  sim->ntolayer3++;
+
+  /* with a bottleneck link the packet has to fit in its buffer, and is
+     then sent whether or not it gets lost on the way */
+  if (linked && (sent = linksend(sim, to, PKTBYTES(packet))) < 0.0) {
+    sim->nqdrop++;
+    TRACEF(1, ("          TOLAYER3: packet dropped, link buffer full\n"));
+    return;
+  }  
+
+  /* a path trace for this direction decides its fate and delay */
+  if (sim->paths[to] != NULL) {
+    rec = pathtrace_record(sim->paths[to], sim->pathnext[to]);
+    if (++sim->pathnext[to] == pathtrace_length(sim->paths[to]))
+      sim->pathnext[to] = 0;
+  }  
+
+  /* simulate losses: */
+  if ((rec != NULL) ? (rec->fate == PT_LOST)
+      : pktlost(sim, AorB, (!(AorB == B && dir == A) && !(AorB == A && dir == B)))) {
+    sim->nlost++;
+    TRACEF(1, ("          TOLAYER3: packet being lost\n"));
+    return;
+  }  
+
+  /* create future event for arrival of packet at the other side, and */
+  /* make a copy of the packet student just gave me inside it since he/she */
+  /* may decide to do something with the packet after we return */
+  evptr = poolget(&sim->evpool);
+  pkt_copy(&evptr->pkt, packet);
+  mypktptr = &evptr->pkt;
+  TRACEF(3, ("          TOLAYER3: seq: %d, ack %d, check: %d %.*s\n", mypktptr->seqnum,
+              mypktptr->acknum,  mypktptr->checksum,
+              mypktptr->length < 20 ? mypktptr->length : 20, mypktptr->payload));
+
+  evptr->evtype =  FROM_LAYER3;   /* packet will pop out from layer3 */
+  evptr->eventity = (AorB+1) % 2; /* event occurs at other entity */
+  evptr->flow = sim->flow;
+  evptr->corrupted = 0;
+  /* finally, compute the arrival time of packet at the other end.
+     medium can not reorder, so make sure packet arrives between 1 and 10
+     time units after the latest arrival time of packets
+     currently in the medium on their way to the destination */
+  if (rec != NULL)                /* the recorded delay, after any link */
+    evptr->evtime = (linked ? sent : sim->time) + rec->delay;
+  else if (linked)                /* sent, then propagation delay */
+    evptr->evtime = sent + sim->cfg.propdelay;
+  else {
+    lastime = sim->time;
+    if (sim->chantail[evptr->eventity] > lastime)
+      lastime = sim->chantail[evptr->eventity];
+    evptr->evtime =  lastime + 1 + 9*jimsrand(sim, RNG_DELAY);
+  }  
+  /* unless the packet is reordered: it is held back by up to reordermax
+     and does not hold up the packets behind it, which may overtake it */
+  if (impair && sim->cfg.reorderprob > 0.0
+      && jimsrand(sim, RNG_IMPAIR) < sim->cfg.reorderprob) {
+    sim->nreorder++;
+    evptr->evtime += sim->cfg.reordermax * jimsrand(sim, RNG_IMPAIR);
+    TRACEF(1, ("          TOLAYER3: packet being reordered\n"));
+  }  
+  else if (!linked && rec == NULL)
+    sim->chantail[evptr->eventity] = evptr->evtime;
+
+
+
+  /* simulate corruption: */
+  if (rec != NULL)
+    fate = rec->fate;
+  else if ((jimsrand(sim, RNG_CORRUPT) < sim->cfg.corruptprob)  && (!(AorB == B && dir == A) && !(AorB == A && dir == B))) {
+    if ( (x = jimsrand(sim, RNG_CORRUPT)) < .75)
+      fate = PT_CORRUPT;
+    else if (x < .875)
+      fate = PT_CORRUPTSEQ;
+    else
+      fate = PT_CORRUPTACK;
+  }  
+  else
+    fate = PT_DELIVERED;
+  if (fate >= PT_CORRUPT) {
+    sim->ncorrupt++;
+    evptr->corrupted = 1;
+    if (fate == PT_CORRUPT)
+      mypktptr->payload[0]='Z';   /* corrupt payload */
+    else if (fate == PT_CORRUPTSEQ)
+      mypktptr->seqnum = 999999;
+    else
+      mypktptr->acknum = 999999;
+    TRACEF(1, ("          TOLAYER3: packet being corrupted\n"));
+  }  
+
+  /* simulate duplication: a copy arrives up to reordermax after it */
+  if (impair && sim->cfg.dupprob > 0.0
+      && jimsrand(sim, RNG_IMPAIR) < sim->cfg.dupprob) {
+    sim->nduplicate++;
+    dupptr = poolget(&sim->evpool);
+    memcpy(dupptr, evptr, offsetof(struct event, pkt));
+    pkt_copy(&dupptr->pkt, &evptr->pkt);
+    dupptr->evtime += sim->cfg.reordermax * jimsrand(sim, RNG_IMPAIR);
+    TRACEF(1, ("          TOLAYER3: packet being duplicated\n"));
+    insertevent(sim, dupptr);
+    sim->inflight++;
+  }  
+
+  TRACEF(3, ("          TOLAYER3: scheduling arrival on other side\n"));
+  insertevent(sim, evptr);
+  sim->inflight++;
+}  
+
+void tolayer5(struct sim *sim, int AorB, const char *datasent, int length)
+{
+  TRACEF(3, ("          TOLAYER5: data received by application at %s: %.*s\n",
+              (AorB == A) ? "A" : "B", length < 20 ? length : 20, datasent));
+  sim->messages_delivered++;
+  sim->flows[sim->flow].delivered++;
+  sim->bytes_delivered += length;
+  msgdelivered(sim, 1 - AorB);
+}  
+
+/* counters sampled around an event handler for the binary trace */
+struct btcounts {
+  int sent, delivered, newacks, resent, windowfull;
+};
+
+static void btcount(struct sim *sim, struct btcounts *c)
+{
+  c->sent = sim->ntolayer3;
+  c->delivered = sim->messages_delivered;
+  c->newacks = sim->stats.new_ACKs;
+  c->resent = sim->stats.packets_resent;
+  c->windowfull = sim->stats.window_full;
+}  
+
+/* record what the handler for event p did since the counters were taken */
+static void btrecord(struct sim *sim, struct event *p, struct btcounts *before, int nomsg)
+{
+  struct btrec rec;
+
+  rec.time = p->evtime;
+  rec.type = p->evtype;
+  rec.entity = p->eventity;
+  rec.flow = p->flow;
+  rec.unused = 0;
+  rec.seqnum = (p->evtype == FROM_LAYER3) ? p->pkt.seqnum : -1;
+  rec.acknum = (p->evtype == FROM_LAYER3) ? p->pkt.acknum : -1;
+  rec.nsent = sim->ntolayer3 - before->sent;
+  rec.ndelivered = sim->messages_delivered - before->delivered;
+  rec.flags = 0;
+  if (p->evtype == FROM_LAYER3 && p->corrupted)
+    rec.flags |= BT_CORRUPT;
+  if (sim->stats.new_ACKs != before->newacks)
+    rec.flags |= BT_NEWACK;
+  if (sim->stats.packets_resent != before->resent)
+    rec.flags |= BT_RESENT;
+  if (sim->stats.window_full != before->windowfull)
+    rec.flags |= BT_WINFULL;
+  if (nomsg)
+    rec.flags |= BT_NOMSG;
+  bintrace_record(sim->bt, &rec);
+}  
+
+/* take the samples due up to time t, before the event at t is handled */
+static void takesamples(struct sim *sim, double t)
+{
+  struct sample s;
+
+  while (sim->nextsample <= t) {
+    s.time = sim->nextsample;
+    s.delivered = sim->messages_delivered;
+    s.bytes = sim->bytes_delivered;
+    s.sent = sim->ntolayer3;
+    s.resent = sim->stats.packets_resent;
+    s.inflight = sim->inflight;
+    sampler_record(sim->sp, &s);
+    sim->nextsample += sim->cfg.sampleinterval;
+  }  
+}  
+
+/* has a series converged: after its warm-up, enough batches and a
+   confidence interval within stopci of the mean? */
+static int converged(struct sim *sim, const struct batchmeans *bm, int *warmup,
+                     double *mean, double *halfwidth)
+{
+  *warmup = batch_warmup(bm);
+  batch_ci(bm, *warmup, mean, halfwidth);
+  return bm->n - *warmup >= sim->cfg.minbatches && *mean > 0.0
+    && *halfwidth <= sim->cfg.stopci * *mean;
+}  
+
+/* end the batches due up to time t, before the event at t is handled,
+   and stop offering messages once throughput and latency have both
+   converged.  The messages already accepted are still delivered. */
+static void endbatches(struct sim *sim, double t)
+{
+  struct hist *h = &sim->latency;
+  double mean, halfwidth;
+  int warmup;
+
+  while (!sim->stopped && sim->nextbatch <= t) {
+    batch_add(&sim->bmtput, (sim->messages_delivered - sim->batchdelivered) / sim->cfg.batchtime);
+    if (h->count > sim->batchlatcount)
+      batch_add(&sim->bmlat, (h->sum - sim->batchlatsum) / (h->count - sim->batchlatcount));
+    sim->batchdelivered = sim->messages_delivered;
+    sim->batchlatcount = h->count;
+    sim->batchlatsum = h->sum;
+    sim->nextbatch += sim->cfg.batchtime;
+    if (converged(sim, &sim->bmtput, &warmup, &mean, &halfwidth)
+        && converged(sim, &sim->bmlat, &warmup, &mean, &halfwidth)) {
+      sim->stopped = 1;
+      TRACEF(1, ("          STOPPING RULE: converged after %d batches, no more messages\n",
+                  sim->bmtput.n));
+    }  
+  }  
+}  
+
+/* may layer 5 offer another message? */
+static int moremsgs(struct sim *sim)
+{
+  return sim->nsim < sim->cfg.nsimmax && !sim->stopped;
+}  
+
+/* offer the next message, of length bytes or the configured size if 0,
+   to entity AorB of the current flow; returns 1 if it was accepted */
+static int offer(struct sim *sim, int AorB, int length)
+{
+  struct msg  msg2give;
+  int refused;                 /* window_full before the message was offered */
+  int i,j;
+
+  /* fill in msg to give with string of same letter */    
+  msg2give.length = sim->cfg.payload;
+  if (length > 0)
+    msg2give.length = length;
+  else if (sim->cfg.minpayload > 0)   /* uniform in [minpayload, payload] */
+    msg2give.length = sim->cfg.minpayload + (int)(jimsrand(sim, RNG_SIZE)
+                        * (sim->cfg.payload - sim->cfg.minpayload + 1));
+  j = sim->nsim % 26;
+  for (i=0; i<msg2give.length; i++)  
+    msg2give.data[i] = 97 + j;
+  TRACEF(3, ("          MAINLOOP: data given to student: %.*s\n",
+              msg2give.length < 20 ? msg2give.length : 20, msg2give.data));
+  sim->nsim++;
+  refused = sim->stats.window_full;
+  if (AorB == A) 
+    sim->proto->A_output(sim, &msg2give);
+  else
+    sim->proto->B_output(sim, &msg2give);
+  if (sim->stats.window_full != refused)
+    return 0;
+  msgaccepted(sim, AorB);      /* not dropped, so accepted */
+  return 1;
+}  
+
+/* a saturated sender: offer entity AorB of the current flow messages
+   until its window is full, then wait for an event at AorB to open it.
+   The message the window refused is kept for next time, so it is
+   neither counted as offered nor as dropped. */
+static void feed(struct sim *sim, int AorB)
+{
+  struct flow *fl = &sim->flows[sim->flow];
+
+  fl->blocked[AorB] = 0;
+  while (moremsgs(sim))
+    if (!offer(sim, AorB, 0)) {
+      sim->nsim--;
+      sim->stats.window_full--;
+      fl->blocked[AorB] = 1;
+      return;
+    }  
+}  
+
+/* run the simulation until the next event is at time t or later, or
+   until no events are left if t < 0; returns 1 if events are left */
+int sim_run_until(struct sim *sim, double t)
+{
+  struct event *eventptr;
+  struct btcounts before;
+  int nomsg;                   /* layer 5 arrival came after the last message */
+  int bintracing = (sim->bt != NULL);
+  int sampling = (sim->sp != NULL);
+  int stopping = (sim->cfg.stopci > 0.0);
+
+  while (1) {
+    if (t >= 0.0 && sim->evcount > 0 && sim->evheap[0]->evtime >= t)
+      return 1;
+    eventptr = popevent(sim);     /* get next event to simulate */
+    if (eventptr==NULL)
+      return 0;
+    TRACEF(2, ("\nEVENT time: %f,  type: %d%s entity: %d\n", eventptr->evtime, eventptr->evtype,
+               (eventptr->evtype==0) ? ", timerinterrupt  " :
+               (eventptr->evtype==1) ? ", fromlayer5 " : ", fromlayer3 ",
+               eventptr->eventity));
+    if (sampling)
+      takesamples(sim, eventptr->evtime);
+    if (stopping)
+      endbatches(sim, eventptr->evtime);
+    sim->time = eventptr->evtime;   /* update time to next event time */
+    sim->flow = eventptr->flow;     /* and the flow handling it */
+    nomsg = 0;
+    if (bintracing)
+      btcount(sim, &before);
+    if (eventptr->evtype == FROM_LAYER5 ) {
+      if (sim->workload == WL_SATURATED && moremsgs(sim))
+        feed(sim, eventptr->eventity);
+      else if (moremsgs(sim)) {
+        generate_next_arrival(sim);   /* set up future arrival */
+        offer(sim, eventptr->eventity, eventptr->pkt.length);
+      }
+      else {
+        TRACEF(3, ("          FROM_LAYER5: no more messages to send: \n"));
+        nomsg = 1;
+      }
+    }
+    else if (eventptr->evtype ==  FROM_LAYER3) {
+      sim->inflight--;
+	    if (eventptr->eventity ==A)      /* deliver packet by calling */
+        sim->proto->A_input(sim, &eventptr->pkt);  /* appropriate entity */
+      else
+        sim->proto->B_input(sim, &eventptr->pkt);
+    }
+    else if (eventptr->evtype ==  TIMER_INTERRUPT) {
+      sim->flows[sim->flow].timers[eventptr->eventity] = NULL;   /* timer has gone off */
+      if (eventptr->eventity == A) 
+        sim->proto->A_timerinterrupt(sim);
+      else
+        sim->proto->B_timerinterrupt(sim);
+    }
+    else  {
+      TRACEF(0, ("INTERNAL PANIC: unknown event type \n"));
+    }
+    /* an ACK or timeout may have opened a saturated sender's window */
+    if (eventptr->evtype != FROM_LAYER5 && sim->flows[sim->flow].blocked[eventptr->eventity])
+      feed(sim, eventptr->eventity);
+    if (bintracing)
+      btrecord(sim, eventptr, &before, nomsg);
+    poolput(&sim->evpool, eventptr);
+  }  
+}  
+
+void sim_run(struct sim *sim)
+{
+  sim_run_until(sim, -1.0);
+}  
+
+/* Jain's fairness index of the messages each flow delivered: 1 when
+   they all delivered the same, down to 1/nflows when one did it all */
+static double fairness(struct sim *sim)
+{
+  double sum = 0.0, sumsq = 0.0;
+  int f;
+
+  for (f = 0; f < sim->nflows; f++) {
+    sum += sim->flows[f].delivered;
+    sumsq += (double)sim->flows[f].delivered * sim->flows[f].delivered;
+  }  
+  return (sumsq > 0.0) ? sum * sum / (sim->nflows * sumsq) : 1.0;
+}  
+
+/* how the stopping rule went */
+static void reportstop(struct sim *sim)
+{
+  double tmean, thw, lmean, lhw;
+  int twarm, lwarm;
+
+  converged(sim, &sim->bmtput, &twarm, &tmean, &thw);
+  converged(sim, &sim->bmlat, &lwarm, &lmean, &lhw);
+  printf("stopping rule: %s after %d batches of %g, warm-up %d and %d batches\n",
+         sim->stopped ? "converged" : "did not converge", sim->bmtput.n, sim->cfg.batchtime,
+         twarm, lwarm);
+  printf("batch means: throughput %f +/- %f, latency %f +/- %f\n", tmean, thw, lmean, lhw);
+}  
+
+void sim_report(struct sim *sim)
+{
+  int f, least, most;
+
+  printf(" Simulator terminated at time %f\n after attempting to send %d msgs from layer5\n",sim->time,sim->nsim);
+  printf("number of messages dropped due to full window:  %d \n", sim->stats.window_full);
+  printf("number of valid (not corrupt or duplicate) acknowledgements received at A:  %d \n", sim->stats.new_ACKs);
+  printf("(note: a single acknowledgement may have acknowledged more than one packet - if cumulative acknowledgements are used)\n");
+  printf("number of packet resends by A:  %d \n", sim->stats.packets_resent);
+  printf("number of correct packets received at B:  %d \n", sim->stats.packets_received);
+  printf("number of messages delivered to application:  %d \n", sim->messages_delivered);
+  printf("number of payload bytes delivered to application:  %ld \n", sim->bytes_delivered);
+  if (sim->cfg.bidirectional)
+    printf("number of ACKs carried by data packets:  %d \n", sim->stats.piggybacked);
+  if (sim->cfg.bitrate > 0.0)
+    printf("number of packets dropped by the link buffer:  %d \n", sim->nqdrop);
+  if (sim->cfg.reorderprob > 0.0 || sim->cfg.dupprob > 0.0)
+    printf("number of packets reordered: %d, duplicated: %d \n", sim->nreorder, sim->nduplicate);
+  if (sim->nflows > 1) {
+    least = most = sim->flows[0].delivered;
+    for (f = 1; f < sim->nflows; f++) {
+      if (sim->flows[f].delivered < least)
+        least = sim->flows[f].delivered;
+      if (sim->flows[f].delivered > most)
+        most = sim->flows[f].delivered;
+    }  
+    printf("%d flows delivered %d to %d messages each, fairness index %f \n",
+           sim->nflows, least, most, fairness(sim));
+  }  
+  if (sim->cfg.stopci > 0.0)
+    reportstop(sim);
+  printf("message latency: mean %f, p50 %f, p90 %f, p99 %f, p99.9 %f, max %f\n",
+         hist_mean(&sim->latency), hist_quantile(&sim->latency, 0.50),
+         hist_quantile(&sim->latency, 0.90), hist_quantile(&sim->latency, 0.99),
+         hist_quantile(&sim->latency, 0.999), sim->latency.max);
+  printf("event pool: %d slabs, high-water mark %d events\n", sim->evpool.nslabs, sim->evpool.highwater);
+}  
+
+void sim_results(struct sim *sim, struct sim_results *res)
+{
+  res->time = sim->time;
+  res->nsim = sim->nsim;
+  res->messages_delivered = sim->messages_delivered;
+  res->bytes_delivered = sim->bytes_delivered;
+  res->fairness = fairness(sim);
+  res->ntolayer3 = sim->ntolayer3;
+  res->nlost = sim->nlost;
+  res->ncorrupt = sim->ncorrupt;
+  res->nqdrop = sim->nqdrop;
+  res->nreorder = sim->nreorder;
+  res->nduplicate = sim->nduplicate;
+  res->window_full = sim->stats.window_full;
+  res->total_ACKs_received = sim->stats.total_ACKs_received;
+  res->new_ACKs = sim->stats.new_ACKs;
+  res->packets_resent = sim->stats.packets_resent;
+  res->packets_received = sim->stats.packets_received;
+  res->piggybacked = sim->stats.piggybacked;
+  res->latmean = hist_mean(&sim->latency);
+  res->latp50 = hist_quantile(&sim->latency, 0.50);
+  res->latp90 = hist_quantile(&sim->latency, 0.90);
+  res->latp99 = hist_quantile(&sim->latency, 0.99);
+  res->latp999 = hist_quantile(&sim->latency, 0.999);
+  res->latmax = sim->latency.max;
+}  
+
+int main(int argc, char **argv)
+{
+  struct simconfig cfg;
+  struct sim *sim;
+  struct sim_results res;
+  struct snapshot *snap = NULL;
+  const char *name;
+  int status = 0;
+
+  config_defaults(&cfg);
+  /* run as gbn or sw, a link to this binary, default to that protocol */
+  name = strrchr(argv[0], '/');
+  name = name != NULL ? name + 1 : argv[0];
+  if (protocol_find(name) != NULL)
+    strcpy(cfg.protocol, name);
+  if (argc > 1) {
+    if (config_parse_args(&cfg, argc, argv) != 0) {
+      config_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    if (cfg.resume[0] != '\0') {
+      /* the snapshot's run parameters, with the flags applied on top */
+      if ((snap = snapshot_load(cfg.resume)) == NULL)
+        return EXIT_FAILURE;
+      cfg = *snapshot_config(snap);
+      cfg.forkat = 0.0;
+      cfg.snapshot[0] = cfg.tracefile[0] = cfg.bintrace[0] = cfg.samplefile[0] = '\0';
+      config_parse_args(&cfg, argc, argv);
+    }  
+    if (config_check(&cfg) != 0 || (cfg.sweep[0] == '\0' && protocol_check(&cfg) != 0)) {
+      config_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    trace_open(cfg.tracefile[0] != '\0' ? cfg.tracefile : NULL);
+  }  
+  else {                        /* no arguments, ask as the original did */
+    trace_open(NULL);
+    config_prompt(&cfg);
+  }  
+  TRACE = cfg.trace;            /* trace level and sink are per process */
+
+  if (cfg.sweep[0] != '\0' || cfg.replications > 1) {
+    TRACE = 0;                  /* traces of parallel runs would interleave */
+    if (cfg.sweep[0] != '\0')   /* parameter sweep, see sweep.h */
+      status = sweep_run(&cfg);
+    else                        /* Monte Carlo experiment, see runner.h */
+      runner_run(&cfg);
+    trace_close();
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }  
+
+  if (snap != NULL) {            /* branch from a snapshot file */
+    sim = sim_fork(snap, &cfg);
+    snapshot_free(snap);
+    if (sim == NULL)
+      return EXIT_FAILURE;
+  }  
+  else
+    sim = sim_create(&cfg);
+
+  if (cfg.snapshot[0] != '\0') { /* run the common prefix and save it */
+    sim_run_until(sim, cfg.forkat);
+    snap = sim_snapshot(sim);
+    status = snapshot_save(snap, cfg.snapshot);
+    if (status == 0)
+      printf("snapshot at time %f written to %s\n", sim->time, cfg.snapshot);
+    snapshot_free(snap);
+    trace_close();
+    sim_destroy(sim);
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }  
+
+  sim_run(sim);
+  trace_close();
+  if (report_format(&cfg) == FORMAT_TEXT)
+    sim_report(sim);
+  else {                        /* one record, see report.h */
+    sim_results(sim, &res);
+    report_begin(report_format(&cfg), 0);
+    report_run(report_format(&cfg), &cfg, &res);
+  }  
+  sim_destroy(sim);
+  return EXIT_SUCCESS;
+}  
\ No newline at end of file
@@ -1,40 +1,76 @@
-extern int TRACE;
-
-/* statistics updated by GBN */
-extern int total_ACKs_received;
-extern int packets_resent;       /* count of the number of packets resent  */
-extern int new_ACKs;      /* count of the number of acks correctly received */
-extern int packets_received;  /* count of the packets received by receiver */
-extern int window_full; /* count of the number of messages dropped due to full window */
-
-#define   A    0
-#define   B    1
-
-/* a "msg" is the data unit passed from layer 5 (teachers code) to layer  */
-/* 4 (students' code).  It contains the data (characters) to be delivered */
-/* to layer 5 via the students transport level protocol entities.         */
-struct msg {
-  char data[20];
-};
-
-/* a packet is the data unit passed from layer 4 (students code) to layer */
-/* 3 (teachers code).  Note the pre-defined packet structure, which all   */
-/* students must follow. */
-struct pkt {
-  int seqnum;
-  int acknum;
-  int checksum;
-  char payload[20];
-};
-
-/* send to A or B (int), packet to send */
-extern void tolayer3(int, struct pkt);  
-
-/* deliver to A or B (int), data to deliver */
-extern void tolayer5(int, char[20]); 
-
-/* start timer at A or B (int), increment */
-extern void starttimer(int, double);       
-
-/* stop timer at A or B (int) */
-extern void stoptimer(int);               
+#include <stddef.h>
+
+extern int TRACE;
+
+/* one simulation run.  Every routine below takes the simulation it
+   belongs to, so several can run in one process; see sim.h */
+struct sim;
+
+/* statistics updated by GBN */
+struct protostats {
+  int total_ACKs_received;
+  int packets_resent;       /* count of the number of packets resent  */
+  int new_ACKs;      /* count of the number of acks correctly received */
+  int packets_received;  /* count of the packets received by receiver */
+  int window_full; /* count of the number of messages dropped due to full window */
+  int piggybacked;   /* ACKs carried by data packets */
+};
+
+#define   A    0
+#define   B    1
+
+#define MAXPAYLOAD 9000   /* a jumbo frame, the largest payload a run can use */
+
+/* a "msg" is the data unit passed from layer 5 (teachers code) to layer  */
+/* 4 (students' code).  It contains the data (characters) to be delivered */
+/* to layer 5 via the students transport level protocol entities.         */
+struct msg {
+  int length;             /* bytes of data, 1 to the run's payload size */
+  char data[MAXPAYLOAD];
+};
+
+/* a packet is the data unit passed from layer 4 (students code) to layer */
+/* 3 (teachers code).  Note the pre-defined packet structure, which all   */
+/* students must follow. */
+struct pkt {
+  int seqnum;
+  int acknum;
+  int checksum;
+  int length;             /* bytes of payload in use */
+  char payload[MAXPAYLOAD];
+};
+
+/* bytes of a packet with a payload of length bytes, rounded up so an
+   array of them stays aligned.  Only this much of a struct pkt is ever
+   copied, and buffers of packets can be laid out this far apart. */
+#define PKTSIZE(length) \
+  ((offsetof(struct pkt, payload) + (length) + sizeof(int) - 1) / sizeof(int) * sizeof(int))
+
+/* copy the header and the payload in use of a packet */
+extern void pkt_copy(struct pkt *to, const struct pkt *from);
+
+/* send to A or B (int), packet to send */
+extern void tolayer3(struct sim *, int, const struct pkt *);  
+
+/* deliver to A or B (int), data to deliver and its length */
+extern void tolayer5(struct sim *, int, const char *, int); 
+
+/* start timer at A or B (int), increment */
+extern void starttimer(struct sim *, int, double);       
+
+/* stop timer at A or B (int) */
+extern void stoptimer(struct sim *, int);
+
+/* the parameters of this simulation, see config.h */
+struct simconfig;
+extern const struct simconfig *sim_config(struct sim *);
+
+/* the current simulated time */
+extern double sim_time(struct sim *);
+
+/* the statistics the protocol updates for this simulation */
+extern struct protostats *sim_stats(struct sim *);
+
+/* the protocol's state for this simulation, protocol_statesize() bytes
+   zeroed before A_init() and B_init() are called */
+extern void *sim_state(struct sim *);
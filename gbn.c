@@ -1,275 +1,344 @@
-#include <stdlib.h>
-#include <stdio.h>
-#include <stdbool.h>
-#include "emulator.h"
-#include "gbn.h"
-
-/* ******************************************************************
-   Go Back N protocol.  Adapted from J.F.Kurose
-   ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.2  
-
-   Network properties:
-   - one way network delay averages five time units (longer if there
-   are other messages in the channel for GBN), but can be larger
-   - packets can be corrupted (either the header or the data portion)
-   or lost, according to user-defined probabilities
-   - packets will be delivered in the order in which they were sent
-   (although some can be lost).
-
-   Modifications: 
-   - removed bidirectional GBN code and other code not used by prac. 
-   - fixed C style to adhere to current programming style
-   - added GBN implementation
-**********************************************************************/
-
-#define RTT  16.0       /* round trip time.  MUST BE SET TO 16.0 when submitting assignment */
-#define WINDOWSIZE 6    /* the maximum number of buffered unacked packet */
-#define SEQSPACE 7      /* the min sequence space for GBN must be at least windowsize + 1 */
-#define NOTINUSE (-1)   /* used to fill header fields that are not being used */
-
-/* generic procedure to compute the checksum of a packet.  Used by both sender and receiver  
-   the simulator will overwrite part of your packet with 'z's.  It will not overwrite your 
-   original checksum.  This procedure must generate a different checksum to the original if
-   the packet is corrupted.
-*/
-int ComputeChecksum(struct pkt packet)
-{
-  int checksum = 0;
-  int i;
-
-  checksum = packet.seqnum;
-  checksum += packet.acknum;
-  for ( i=0; i<20; i++ ) 
-    checksum += (int)(packet.payload[i]);
-
-  return checksum;
-}
-
-bool IsCorrupted(struct pkt packet)
-{
-  if (packet.checksum == ComputeChecksum(packet))
-    return (false);
-  else
-    return (true);
-}
-
-
-/********* Sender (A) variables and functions ************/
-
-static struct pkt buffer[WINDOWSIZE];  /* array for storing packets waiting for ACK */
-static int windowfirst, windowlast;    /* array indexes of the first/last packet awaiting ACK */
-static int windowcount;                /* the number of packets currently awaiting an ACK */
-static int A_nextseqnum;               /* the next sequence number to be used by the sender */
-
-/* called from layer 5 (application layer), passed the message to be sent to other side */
-void A_output(struct msg message)
-{
-  struct pkt sendpkt;
-  int i;
-
-  /* if not blocked waiting on ACK */
-  if ( windowcount < WINDOWSIZE) {
-    if (TRACE > 1)
-      printf("----A: New message arrives, send window is not full, send new messge to layer3!\n");
-
-    /* create packet */
-    sendpkt.seqnum = A_nextseqnum;
-    sendpkt.acknum = NOTINUSE;
-    for ( i=0; i<20 ; i++ ) 
-      sendpkt.payload[i] = message.data[i];
-    sendpkt.checksum = ComputeChecksum(sendpkt); 
-
-    /* put packet in window buffer */
-    /* windowlast will always be 0 for alternating bit; but not for GoBackN */
-    windowlast = (windowlast + 1) % WINDOWSIZE; 
-    buffer[windowlast] = sendpkt;
-    windowcount++;
-
-    /* send out packet */
-    if (TRACE > 0)
-      printf("Sending packet %d to layer 3\n", sendpkt.seqnum);
-    tolayer3 (A, sendpkt);
-
-    /* start timer if first packet in window */
-    if (windowcount == 1)
-      starttimer(A,RTT);
-
-    /* get next sequence number, wrap back to 0 */
-    A_nextseqnum = (A_nextseqnum + 1) % SEQSPACE;  
-  }
-  /* if blocked,  window is full */
-  else {
-    if (TRACE > 0)
-      printf("----A: New message arrives, send window is full\n");
-    window_full++;
-  }
-}
-
-
-/* called from layer 3, when a packet arrives for layer 4 
-   In this practical this will always be an ACK as B never sends data.
-*/
-void A_input(struct pkt packet)
-{
-  int ackcount = 0;
-  int i;
-
-  /* if received ACK is not corrupted */ 
-  if (!IsCorrupted(packet)) {
-    if (TRACE > 0)
-      printf("----A: uncorrupted ACK %d is received\n",packet.acknum);
-    total_ACKs_received++;
-
-    /* check if new ACK or duplicate */
-    if (windowcount != 0) {
-          int seqfirst = buffer[windowfirst].seqnum;
-          int seqlast = buffer[windowlast].seqnum;
-          /* check case when seqnum has and hasn't wrapped */
-          if (((seqfirst <= seqlast) && (packet.acknum >= seqfirst && packet.acknum <= seqlast)) ||
-              ((seqfirst > seqlast) && (packet.acknum >= seqfirst || packet.acknum <= seqlast))) {
-
-            /* packet is a new ACK */
-            if (TRACE > 0)
-              printf("----A: ACK %d is not a duplicate\n",packet.acknum);
-            new_ACKs++;
-
-            /* cumulative acknowledgement - determine how many packets are ACKed */
-            if (packet.acknum >= seqfirst)
-              ackcount = packet.acknum + 1 - seqfirst;
-            else
-              ackcount = SEQSPACE - seqfirst + packet.acknum;
-
-	    /* slide window by the number of packets ACKed */
-            windowfirst = (windowfirst + ackcount) % WINDOWSIZE;
-
-            /* delete the acked packets from window buffer */
-            for (i=0; i<ackcount; i++)
-              windowcount--;
-
-	    /* start timer again if there are still more unacked packets in window */
-            stoptimer(A);
-            if (windowcount > 0)
-              starttimer(A, RTT);
-
-          }
-        }
-        else
-          if (TRACE > 0)
-        printf ("----A: duplicate ACK received, do nothing!\n");
-  }
-  else 
-    if (TRACE > 0)
-      printf ("----A: corrupted ACK is received, do nothing!\n");
-}
-
-/* called when A's timer goes off */
-void A_timerinterrupt(void)
-{
-  int i;
-
-  if (TRACE > 0)
-    printf("----A: time out,resend packets!\n");
-
-  for(i=0; i<windowcount; i++) {
-
-    if (TRACE > 0)
-      printf ("---A: resending packet %d\n", (buffer[(windowfirst+i) % WINDOWSIZE]).seqnum);
-
-    tolayer3(A,buffer[(windowfirst+i) % WINDOWSIZE]);
-    packets_resent++;
-    if (i==0) starttimer(A,RTT);
-  }
-}       
-
-
-
-/* the following routine will be called once (only) before any other */
-/* entity A routines are called. You can use it to do any initialization */
-void A_init(void)
-{
-  /* initialise A's window, buffer and sequence number */
-  A_nextseqnum = 0;  /* A starts with seq num 0, do not change this */
-  windowfirst = 0;
-  windowlast = -1;   /* windowlast is where the last packet sent is stored.  
-		     new packets are placed in winlast + 1 
-		     so initially this is set to -1
-		   */
-  windowcount = 0;
-}
-
-
-
-/********* Receiver (B)  variables and procedures ************/
-
-static int expectedseqnum; /* the sequence number expected next by the receiver */
-static int B_nextseqnum;   /* the sequence number for the next packets sent by B */
-
-
-/* called from layer 3, when a packet arrives for layer 4 at B*/
-void B_input(struct pkt packet)
-{
-  struct pkt sendpkt;
-  int i;
-
-  /* if not corrupted and received packet is in order */
-  if  ( (!IsCorrupted(packet))  && (packet.seqnum == expectedseqnum) ) {
-    if (TRACE > 0)
-      printf("----B: packet %d is correctly received, send ACK!\n",packet.seqnum);
-    packets_received++;
-
-    /* deliver to receiving application */
-    tolayer5(B, packet.payload);
-
-    /* send an ACK for the received packet */
-    sendpkt.acknum = expectedseqnum;
-
-    /* update state variables */
-    expectedseqnum = (expectedseqnum + 1) % SEQSPACE;        
-  }
-  else {
-    /* packet is corrupted or out of order resend last ACK */
-    if (TRACE > 0) 
-      printf("----B: packet corrupted or not expected sequence number, resend ACK!\n");
-    if (expectedseqnum == 0)
-      sendpkt.acknum = SEQSPACE - 1;
-    else
-      sendpkt.acknum = expectedseqnum - 1;
-  }
-
-  /* create packet */
-  sendpkt.seqnum = B_nextseqnum;
-  B_nextseqnum = (B_nextseqnum + 1) % 2;
-    
-  /* we don't have any data to send.  fill payload with 0's */
-  for ( i=0; i<20 ; i++ ) 
-    sendpkt.payload[i] = '0';  
-
-  /* computer checksum */
-  sendpkt.checksum = ComputeChecksum(sendpkt); 
-
-  /* send out packet */
-  tolayer3 (B, sendpkt);
-}
-
-/* the following routine will be called once (only) before any other */
-/* entity B routines are called. You can use it to do any initialization */
-void B_init(void)
-{
-  expectedseqnum = 0;
-  B_nextseqnum = 1;
-}
-
-/******************************************************************************
- * The following functions need be completed only for bi-directional messages *
- *****************************************************************************/
-
-/* Note that with simplex transfer from a-to-B, there is no B_output() */
-void B_output(struct msg message)  
-{
-}
-
-/* called when B's timer goes off */
-void B_timerinterrupt(void)
-{
-}
-
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "emulator.h"
+#include "config.h"
+#include "protocol.h"
+#include "gbn.h"
+#include "trace.h"
+
+/* ******************************************************************
+   Go Back N protocol.  Adapted from J.F.Kurose
+   ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.2  
+
+   Network properties:
+   - one way network delay averages five time units (longer if there
+   are other messages in the channel for GBN), but can be larger
+   - packets can be corrupted (either the header or the data portion)
+   or lost, according to user-defined probabilities
+   - packets will be delivered in the order in which they were sent
+   (although some can be lost).
+
+   Modifications: 
+   - removed bidirectional GBN code and other code not used by prac. 
+   - fixed C style to adhere to current programming style
+   - added GBN implementation
+**********************************************************************/
+
+#define RTT  16.0       /* round trip time.  MUST BE SET TO 16.0 when submitting assignment */
+#define WINDOWSIZE 6    /* default maximum number of buffered unacked packet, see -window */
+#define SEQSPACE 7      /* default sequence space, see -seqspace; for GBN it must be at least windowsize + 1 */
+#define NOTINUSE (-1)   /* used to fill header fields that are not being used */
+
+/* generic procedure to compute the checksum of a packet.  Used by both sender and receiver  
+   the simulator will overwrite part of your packet with 'z's.  It will not overwrite your 
+   original checksum.  This procedure must generate a different checksum to the original if
+   the packet is corrupted.
+*/
+static int ComputeChecksum(const struct pkt *packet)
+{
+  int checksum = 0;
+  int i;
+
+  checksum = packet->seqnum;
+  checksum += packet->acknum;
+  for ( i=0; i<packet->length; i++ ) 
+    checksum += (int)(packet->payload[i]);
+
+  return checksum;
+}
+
+static bool IsCorrupted(const struct pkt *packet)
+{
+  if (packet->checksum == ComputeChecksum(packet))
+    return (false);
+  else
+    return (true);
+}
+
+
+/* window and sequence space of a run: as configured, or the defaults */
+static int cfgwindow(const struct simconfig *cfg)
+{
+  return cfg->windowsize > 0 ? cfg->windowsize : WINDOWSIZE;
+}
+
+static int cfgseqspace(const struct simconfig *cfg)
+{
+  if (cfg->seqspace > 0)
+    return cfg->seqspace;
+  return cfgwindow(cfg) + 1 > SEQSPACE ? cfgwindow(cfg) + 1 : SEQSPACE;
+}
+
+static int check(const struct simconfig *cfg)
+{
+  if (cfgwindow(cfg) < 1 || cfgseqspace(cfg) < cfgwindow(cfg) + 1) {
+    fprintf(stderr, "Go Back N needs window >= 1 and seqspace >= window + 1\n");
+    return -1;
+  }
+  if (cfg->bidirectional) {
+    fprintf(stderr, "Go Back N only sends from A to B\n");
+    return -1;
+  }
+  return 0;
+}
+
+struct gbn_sender {
+  int windowfirst, windowlast;    /* array indexes of the first/last packet awaiting ACK */
+  int windowcount;                /* the number of packets currently awaiting an ACK */
+  int A_nextseqnum;               /* the next sequence number to be used by the sender */
+};
+
+struct gbn_receiver {
+  int expectedseqnum; /* the sequence number expected next by the receiver */
+  int B_nextseqnum;   /* the sequence number for the next packets sent by B */
+};
+
+/* the state the emulator keeps for each simulation.  It is followed in
+   the same block by A's buffer of windowsize packets waiting for ACK,
+   pktsize bytes apart, so it holds no pointers and stays valid wherever
+   it is copied. */
+struct gbn_state {
+  int windowsize;
+  int seqspace;
+  int pktsize;                    /* PKTSIZE() of the run's payload */
+  int acklength;                  /* payload bytes of an ACK */
+  struct gbn_sender sender;
+  struct gbn_receiver receiver;
+};
+
+#define STATE(sim)    ((struct gbn_state *)sim_state(sim))
+#define SENDER(sim)   (&STATE(sim)->sender)
+#define RECEIVER(sim) (&STATE(sim)->receiver)
+#define BUFFER(sim, i) ((struct pkt *)((char *)(STATE(sim) + 1) + (i) * STATE(sim)->pktsize))
+
+static size_t statesize(const struct simconfig *cfg)
+{
+  return sizeof(struct gbn_state) + cfgwindow(cfg) * PKTSIZE(cfg->payload);
+}
+
+/* record the window, sequence space and packet sizes, from A_init()
+   and B_init() */
+static void setup(struct sim *sim)
+{
+  STATE(sim)->windowsize = cfgwindow(sim_config(sim));
+  STATE(sim)->seqspace = cfgseqspace(sim_config(sim));
+  STATE(sim)->pktsize = PKTSIZE(sim_config(sim)->payload);
+  STATE(sim)->acklength = sim_config(sim)->payload < 20 ? sim_config(sim)->payload : 20;
+}
+
+
+/********* Sender (A) variables and functions ************/
+
+/* called from layer 5 (application layer), passed the message to be sent to other side */
+static void A_output(struct sim *sim, const struct msg *message)
+{
+  struct gbn_sender *s = SENDER(sim);
+  int windowsize = STATE(sim)->windowsize;
+  struct pkt *sendpkt;
+
+  /* if not blocked waiting on ACK */
+  if ( s->windowcount < windowsize) {
+    TRACEF(2, ("----A: New message arrives, send window is not full, send new messge to layer3!\n"));
+
+    /* create packet, in its place in the window buffer */
+    /* windowlast will always be 0 for alternating bit; but not for GoBackN */
+    s->windowlast = (s->windowlast + 1) % windowsize; 
+    sendpkt = BUFFER(sim, s->windowlast);
+    sendpkt->seqnum = s->A_nextseqnum;
+    sendpkt->acknum = NOTINUSE;
+    sendpkt->length = message->length;
+    memcpy(sendpkt->payload, message->data, message->length);
+    sendpkt->checksum = ComputeChecksum(sendpkt); 
+    s->windowcount++;
+
+    /* send out packet */
+    TRACEF(1, ("Sending packet %d to layer 3\n", sendpkt->seqnum));
+    tolayer3(sim, A, sendpkt);
+
+    /* start timer if first packet in window */
+    if (s->windowcount == 1)
+      starttimer(sim, A,RTT);
+
+    /* get next sequence number, wrap back to 0 */
+    s->A_nextseqnum = (s->A_nextseqnum + 1) % STATE(sim)->seqspace;  
+  }
+  /* if blocked,  window is full */
+  else {
+    TRACEF(1, ("----A: New message arrives, send window is full\n"));
+    sim_stats(sim)->window_full++;
+  }
+}
+
+
+/* called from layer 3, when a packet arrives for layer 4 
+   In this practical this will always be an ACK as B never sends data.
+*/
+static void A_input(struct sim *sim, const struct pkt *packet)
+{
+  struct gbn_sender *s = SENDER(sim);
+  int ackcount = 0;
+  int i;
+
+  /* if received ACK is not corrupted */ 
+  if (!IsCorrupted(packet)) {
+    TRACEF(1, ("----A: uncorrupted ACK %d is received\n",packet->acknum));
+    sim_stats(sim)->total_ACKs_received++;
+
+    /* check if new ACK or duplicate */
+    if (s->windowcount != 0) {
+          int seqfirst = BUFFER(sim, s->windowfirst)->seqnum;
+          int seqlast = BUFFER(sim, s->windowlast)->seqnum;
+          /* check case when seqnum has and hasn't wrapped */
+          if (((seqfirst <= seqlast) && (packet->acknum >= seqfirst && packet->acknum <= seqlast)) ||
+              ((seqfirst > seqlast) && (packet->acknum >= seqfirst || packet->acknum <= seqlast))) {
+
+            /* packet is a new ACK */
+            TRACEF(1, ("----A: ACK %d is not a duplicate\n",packet->acknum));
+            sim_stats(sim)->new_ACKs++;
+
+            /* cumulative acknowledgement - determine how many packets are ACKed */
+            if (packet->acknum >= seqfirst)
+              ackcount = packet->acknum + 1 - seqfirst;
+            else
+              ackcount = STATE(sim)->seqspace - seqfirst + packet->acknum;
+
+	    /* slide window by the number of packets ACKed */
+            s->windowfirst = (s->windowfirst + ackcount) % STATE(sim)->windowsize;
+
+            /* delete the acked packets from window buffer */
+            for (i=0; i<ackcount; i++)
+              s->windowcount--;
+
+	    /* start timer again if there are still more unacked packets in window */
+            stoptimer(sim, A);
+            if (s->windowcount > 0)
+              starttimer(sim, A, RTT);
+
+          }
+        }
+        else
+          TRACEF(1, ("----A: duplicate ACK received, do nothing!\n"));
+  }
+  else 
+    TRACEF(1, ("----A: corrupted ACK is received, do nothing!\n"));
+}
+
+/* called when A's timer goes off */
+static void A_timerinterrupt(struct sim *sim)
+{
+  struct gbn_sender *s = SENDER(sim);
+  int windowsize = STATE(sim)->windowsize;
+  int i;
+
+  TRACEF(1, ("----A: time out,resend packets!\n"));
+
+  for(i=0; i<s->windowcount; i++) {
+
+    TRACEF(1, ("---A: resending packet %d\n", BUFFER(sim, (s->windowfirst+i) % windowsize)->seqnum));
+
+    tolayer3(sim, A, BUFFER(sim, (s->windowfirst+i) % windowsize));
+    sim_stats(sim)->packets_resent++;
+    if (i==0) starttimer(sim, A,RTT);
+  }
+}       
+
+
+
+/* the following routine will be called once (only) before any other */
+/* entity A routines are called. You can use it to do any initialization */
+static void A_init(struct sim *sim)
+{
+  struct gbn_sender *s = SENDER(sim);
+
+  setup(sim);
+  /* initialise A's window, buffer and sequence number */
+  s->A_nextseqnum = 0;  /* A starts with seq num 0, do not change this */
+  s->windowfirst = 0;
+  s->windowlast = -1;   /* windowlast is where the last packet sent is stored.  
+		     new packets are placed in winlast + 1 
+		     so initially this is set to -1
+		   */
+  s->windowcount = 0;
+}
+
+
+
+/********* Receiver (B)  variables and procedures ************/
+
+/* called from layer 3, when a packet arrives for layer 4 at B*/
+static void B_input(struct sim *sim, const struct pkt *packet)
+{
+  struct gbn_receiver *s = RECEIVER(sim);
+  struct pkt sendpkt;
+  int i;
+
+  /* if not corrupted and received packet is in order */
+  if  ( (!IsCorrupted(packet))  && (packet->seqnum == s->expectedseqnum) ) {
+    TRACEF(1, ("----B: packet %d is correctly received, send ACK!\n",packet->seqnum));
+    sim_stats(sim)->packets_received++;
+
+    /* deliver to receiving application */
+    tolayer5(sim, B, packet->payload, packet->length);
+
+    /* send an ACK for the received packet */
+    sendpkt.acknum = s->expectedseqnum;
+
+    /* update state variables */
+    s->expectedseqnum = (s->expectedseqnum + 1) % STATE(sim)->seqspace;        
+  }
+  else {
+    /* packet is corrupted or out of order resend last ACK */
+    TRACEF(1, ("----B: packet corrupted or not expected sequence number, resend ACK!\n"));
+    if (s->expectedseqnum == 0)
+      sendpkt.acknum = STATE(sim)->seqspace - 1;
+    else
+      sendpkt.acknum = s->expectedseqnum - 1;
+  }
+
+  /* create packet */
+  sendpkt.seqnum = s->B_nextseqnum;
+  s->B_nextseqnum = (s->B_nextseqnum + 1) % 2;
+    
+  /* we don't have any data to send.  fill payload with 0's */
+  sendpkt.length = STATE(sim)->acklength;
+  for ( i=0; i<sendpkt.length ; i++ ) 
+    sendpkt.payload[i] = '0';  
+
+  /* computer checksum */
+  sendpkt.checksum = ComputeChecksum(&sendpkt); 
+
+  /* send out packet */
+  tolayer3(sim, B, &sendpkt);
+}
+
+/* the following routine will be called once (only) before any other */
+/* entity B routines are called. You can use it to do any initialization */
+static void B_init(struct sim *sim)
+{
+  struct gbn_receiver *s = RECEIVER(sim);
+
+  setup(sim);
+  s->expectedseqnum = 0;
+  s->B_nextseqnum = 1;
+}
+
+/******************************************************************************
+ * The following functions need be completed only for bi-directional messages *
+ *****************************************************************************/
+
+/* Note that with simplex transfer from a-to-B, there is no B_output() */
+static void B_output(struct sim *sim, const struct msg *message)  
+{
+}
+
+/* called when B's timer goes off */
+static void B_timerinterrupt(struct sim *sim)
+{
+}
+
+const struct protocol gbn_protocol = {
+  "gbn", check, statesize, A_init, B_init, A_input, B_input,
+  A_output, B_output, A_timerinterrupt, B_timerinterrupt
+};
@@ -0,0 +1,85 @@
+#include <string.h>
+#include "hist.h"
+
+/* ******************************************************************
+   Log-bucketed latency histograms, see hist.h
+**********************************************************************/
+
+#define SUB   (1UL << HIST_SUBBITS)
+#define HALF  (1UL << (HIST_SUBBITS - 1))
+#define TOP   ((1UL << (HIST_TOPBIT - 1)) - 1 + (1UL << (HIST_TOPBIT - 1)))
+
+/* bucket of a tick count */
+static int bucketof(unsigned long ticks)
+{
+  unsigned long top = ticks;
+  int shift = 0;
+
+  if (ticks < SUB)
+    return (int)ticks;
+  /* keep the HIST_SUBBITS high bits, the leading one lands in HALF */
+  while (top >= SUB) {
+    top >>= 1;
+    shift++;
+  }
+  return (int)(SUB + (shift - 1) * HALF + (top - HALF));
+}
+
+/* largest tick count that falls in bucket b */
+static unsigned long bucketmax(int b)
+{
+  unsigned long shift, top;
+
+  if ((unsigned long)b < SUB)
+    return (unsigned long)b;
+  shift = (b - SUB) / HALF + 1;
+  top = (b - SUB) % HALF + HALF;
+  return ((top + 1) << shift) - 1;
+}
+
+void hist_init(struct hist *h)
+{
+  memset(h, 0, sizeof(*h));
+}
+
+void hist_record(struct hist *h, double value)
+{
+  double ticks;
+
+  if (value < 0.0)
+    value = 0.0;
+  if (h->count == 0 || value < h->min)
+    h->min = value;
+  if (h->count == 0 || value > h->max)
+    h->max = value;
+  h->count++;
+  h->sum += value;
+
+  ticks = value * HIST_SCALE;
+  h->buckets[bucketof(ticks < (double)TOP ? (unsigned long)ticks : TOP)]++;
+}
+
+double hist_quantile(const struct hist *h, double q)
+{
+  double rank, value;
+  long seen = 0;
+  int b;
+
+  if (h->count == 0)
+    return 0.0;
+  rank = q * h->count;          /* the value with this many at or below it */
+  if (rank < 1.0)
+    rank = 1.0;
+  for (b = 0; b < HIST_NBUCKETS; b++) {
+    seen += h->buckets[b];
+    if (seen >= rank)
+      break;
+  }
+  value = (bucketmax(b) + 1) / HIST_SCALE;
+  return value < h->max ? value : h->max;
+}
+
+double hist_mean(const struct hist *h)
+{
+  return h->count > 0 ? h->sum / h->count : 0.0;
+}
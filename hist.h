@@ -0,0 +1,41 @@
+/* ******************************************************************
+   Log-bucketed latency histograms, in the style of HdrHistogram.
+
+   Values are recorded in ticks of 1/HIST_SCALE time units.  Ticks below
+   2^HIST_SUBBITS get a bucket each; above that every power of two range
+   is split into 2^(HIST_SUBBITS-1) equal buckets, so a bucket is never
+   wider than 1/128 of the values in it.  Recording is a few shifts and
+   an increment, and quantiles are read by walking the buckets.  Values
+   beyond the top bucket are clamped to it; the exact minimum, maximum
+   and mean are tracked on the side.
+**********************************************************************/
+
+#ifndef HIST_H
+#define HIST_H
+
+#define HIST_SCALE   1000.0     /* ticks per simulated time unit */
+#define HIST_SUBBITS 8
+#define HIST_TOPBIT  32         /* ticks are kept below 2^HIST_TOPBIT */
+#define HIST_NBUCKETS ((1 << HIST_SUBBITS) \
+                       + (HIST_TOPBIT - HIST_SUBBITS) * (1 << (HIST_SUBBITS - 1)))
+
+struct hist {
+  long count;               /* values recorded */
+  double sum;               /* of the values, for the mean */
+  double min, max;          /* exact extremes, 0 while empty */
+  long buckets[HIST_NBUCKETS];
+};
+
+/* empty the histogram */
+extern void hist_init(struct hist *h);
+
+/* record one value, negative values count as 0 */
+extern void hist_record(struct hist *h, double value);
+
+/* the value at quantile q in [0,1]: the upper end of the bucket holding
+   it, but never more than the maximum; 0 while empty */
+extern double hist_quantile(const struct hist *h, double q);
+
+extern double hist_mean(const struct hist *h);
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pathtrace.h"
+
+/* ******************************************************************
+   pathencode: turn a text path capture into a path trace.
+
+   usage: pathencode capture.txt trace.path
+
+   Each line of the capture describes one packet, in the order they
+   were sent: its one-way delay, optionally followed by what happened
+   to it, "delivered" (the default), "lost", "corrupt" (the payload),
+   "corruptseq" or "corruptack".  Blank lines and lines starting with
+   # are skipped.
+
+   Build with: gcc -Wall -ansi -pedantic -o pathencode pathencode.c
+**********************************************************************/
+
+static const char *fatename[PT_NFATES] = {
+  "delivered", "lost", "corrupt", "corruptseq", "corruptack"
+};
+
+int main(int argc, char **argv)
+{
+  struct pthdr hdr;
+  struct ptrec rec;
+  FILE *in, *out;
+  char line[256], word[32];
+  long lineno = 0;
+  int n, fate;
+
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s capture.txt trace.path\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  in = fopen(argv[1], "r");
+  if (in == NULL) {
+    fprintf(stderr, "%s: unable to open %s\n", argv[0], argv[1]);
+    return EXIT_FAILURE;
+  }
+  out = fopen(argv[2], "wb");
+  if (out == NULL) {
+    fprintf(stderr, "%s: unable to open %s\n", argv[0], argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  /* the header is rewritten with the count at the end */
+  memset(&hdr, 0, sizeof(hdr));
+  strcpy(hdr.magic, PT_MAGIC);
+  hdr.recsize = sizeof(struct ptrec);
+  fwrite(&hdr, sizeof(hdr), 1, out);
+
+  memset(&rec, 0, sizeof(rec));
+  while (fgets(line, sizeof(line), in) != NULL) {
+    lineno++;
+    n = sscanf(line, "%f %31s", &rec.delay, word);
+    if (n < 1) {
+      if (sscanf(line, " %1s", word) < 1 || word[0] == '#')
+        continue;
+      fprintf(stderr, "%s: %s line %ld: expected a delay\n", argv[0], argv[1], lineno);
+      return EXIT_FAILURE;
+    }
+    fate = PT_DELIVERED;
+    if (n == 2)
+      for (fate = 0; fate < PT_NFATES && strcmp(word, fatename[fate]) != 0; fate++)
+        ;
+    if (fate == PT_NFATES || rec.delay < 0.0) {
+      fprintf(stderr, "%s: %s line %ld: bad delay or fate\n", argv[0], argv[1], lineno);
+      return EXIT_FAILURE;
+    }
+    rec.fate = fate;
+    if (fwrite(&rec, sizeof(rec), 1, out) != 1) {
+      fprintf(stderr, "%s: error writing %s\n", argv[0], argv[2]);
+      return EXIT_FAILURE;
+    }
+    hdr.nrecs++;
+  }
+  fclose(in);
+
+  if (hdr.nrecs == 0) {
+    fprintf(stderr, "%s: %s holds no packets\n", argv[0], argv[1]);
+    return EXIT_FAILURE;
+  }
+  if (fseek(out, 0L, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, out) != 1
+      || fclose(out) != 0) {
+    fprintf(stderr, "%s: error writing %s\n", argv[0], argv[2]);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
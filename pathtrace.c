@@ -0,0 +1,87 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pathtrace.h"
+
+/* ******************************************************************
+   Memory mapped path traces, see pathtrace.h
+**********************************************************************/
+
+struct pathtrace {
+  void *map;              /* the whole file */
+  size_t mapsize;
+  const struct ptrec *recs;
+  long nrecs;
+};
+
+struct pathtrace *pathtrace_open(const char *path)
+{
+  struct pathtrace *pt;
+  const struct pthdr *hdr;
+  struct stat st;
+  void *map;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "unable to open path trace %s\n", path);
+    if (fd >= 0)
+      close(fd);
+    return NULL;
+  }
+  if (st.st_size < (off_t)sizeof(struct pthdr)) {
+    fprintf(stderr, "%s is not a path trace\n", path);
+    close(fd);
+    return NULL;
+  }
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);              /* the mapping outlives the descriptor */
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "unable to map path trace %s\n", path);
+    return NULL;
+  }
+
+  hdr = map;
+  if (memcmp(hdr->magic, PT_MAGIC, sizeof(PT_MAGIC)) != 0
+      || hdr->recsize != (long)sizeof(struct ptrec) || hdr->nrecs < 1
+      || (st.st_size - sizeof(struct pthdr)) / sizeof(struct ptrec) < (size_t)hdr->nrecs) {
+    fprintf(stderr, "%s is not a path trace, was written on another kind of machine or is truncated\n", path);
+    munmap(map, st.st_size);
+    return NULL;
+  }
+  /* runs walk the trace front to back */
+  posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+  pt = malloc(sizeof(struct pathtrace));
+  if (pt == NULL) {
+    printf("memory allocation for path trace failed.");
+    exit(EXIT_FAILURE);
+  }
+  pt->map = map;
+  pt->mapsize = st.st_size;
+  pt->recs = (const struct ptrec *)(hdr + 1);
+  pt->nrecs = hdr->nrecs;
+  return pt;
+}
+
+long pathtrace_length(const struct pathtrace *pt)
+{
+  return pt->nrecs;
+}
+
+const struct ptrec *pathtrace_record(const struct pathtrace *pt, long i)
+{
+  return &pt->recs[i];
+}
+
+void pathtrace_close(struct pathtrace *pt)
+{
+  munmap(pt->map, pt->mapsize);
+  free(pt);
+}
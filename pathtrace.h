@@ -0,0 +1,60 @@
+/* ******************************************************************
+   Path traces: recorded channel behaviour to replay.
+
+   A path trace holds one record per packet sent along one direction of
+   a real path: whether it was lost or corrupted, and how long it took
+   to arrive.  With a trace set for a direction, each tolayer3() call
+   takes the next record's fate and delay instead of drawing them from
+   the random streams, so runs against the same trace see exactly the
+   same channel.  The trace wraps around if a run sends more packets
+   than it holds.
+
+   Traces are mapped into memory rather than read, so a long capture
+   costs address space but only the pages the run reaches; several runs
+   (replications, sweep points) on the same trace share those pages.
+
+   File layout: a struct pthdr followed by hdr.nrecs struct ptrec, in
+   the native byte order and type sizes like the binary event trace.
+   pathencode builds one from a text capture.
+**********************************************************************/
+
+#ifndef PATHTRACE_H
+#define PATHTRACE_H
+
+#define PT_MAGIC     "RTPATH1"   /* 7 characters plus the terminator */
+
+/* what became of a packet */
+#define PT_DELIVERED    0
+#define PT_LOST         1
+#define PT_CORRUPT      2   /* payload corrupted */
+#define PT_CORRUPTSEQ   3   /* seqnum corrupted */
+#define PT_CORRUPTACK   4   /* acknum corrupted */
+#define PT_NFATES       5
+
+struct pthdr {
+  char magic[8];          /* PT_MAGIC */
+  long recsize;           /* sizeof(struct ptrec) when written */
+  long nrecs;             /* records that follow, at least one */
+};
+
+struct ptrec {
+  float delay;            /* time from sending to arrival */
+  unsigned char fate;     /* PT_* */
+  unsigned char unused[3];
+};
+
+struct pathtrace;         /* one mapped trace, see pathtrace.c */
+
+/* map a trace; prints why and returns NULL if it cannot be used */
+extern struct pathtrace *pathtrace_open(const char *path);
+
+/* number of records in the trace */
+extern long pathtrace_length(const struct pathtrace *pt);
+
+/* record i of the trace, i < pathtrace_length() */
+extern const struct ptrec *pathtrace_record(const struct pathtrace *pt, long i);
+
+/* unmap the trace */
+extern void pathtrace_close(struct pathtrace *pt);
+
+#endif
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "protocol.h"
+#include "sr.h"
+#include "gbn.h"
+#include "sw.h"
+
+/* ******************************************************************
+   The protocol registry, see protocol.h
+**********************************************************************/
+
+static const struct protocol *protocols[] = { &sr_protocol, &gbn_protocol, &sw_protocol };
+#define NPROTOCOLS ((int)(sizeof(protocols) / sizeof(protocols[0])))
+
+const struct protocol *protocol_find(const char *name)
+{
+  int i;
+
+  for (i = 0; i < NPROTOCOLS; i++)
+    if (strcmp(name, protocols[i]->name) == 0)
+      return protocols[i];
+  return NULL;
+}
+
+int protocol_check(const struct simconfig *cfg)
+{
+  const struct protocol *p = protocol_find(cfg->protocol);
+  int i;
+
+  if (p == NULL) {
+    fprintf(stderr, "protocol must be");
+    for (i = 0; i < NPROTOCOLS; i++)
+      fprintf(stderr, "%s %s", i == 0 ? "" : (i + 1 < NPROTOCOLS ? "," : " or"),
+              protocols[i]->name);
+    fprintf(stderr, "\n");
+    return -1;
+  }
+  return p->check(cfg);
+}
+
+size_t protocol_statesize(const struct simconfig *cfg)
+{
+  const struct protocol *p = protocol_find(cfg->protocol);
+
+  return p != NULL ? p->statesize(cfg) : 0;
+}
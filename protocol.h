@@ -0,0 +1,48 @@
+/* ******************************************************************
+   The protocols linked into the emulator.
+
+   Each protocol (sr.c, gbn.c, sw.c) keeps its entry points to itself
+   and exports one struct protocol naming them; -protocol picks one at
+   run time and the emulator calls it through the struct.  All of them
+   are in the one binary, so a sweep over -protocol runs them side by
+   side on the same random streams.  To add one, write its file in the
+   style of gbn.c, declare its struct protocol in a header of its own
+   and list it in protocol.c.
+**********************************************************************/
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+
+struct sim;
+struct pkt;
+struct msg;
+struct simconfig;
+
+struct protocol {
+  const char *name;           /* as given to -protocol */
+  /* can the protocol run this configuration?  0, or -1 with a message */
+  int (*check)(const struct simconfig *);
+  /* bytes of protocol state a flow of a run with this configuration needs */
+  size_t (*statesize)(const struct simconfig *);
+  void (*A_init)(struct sim *);
+  void (*B_init)(struct sim *);
+  void (*A_input)(struct sim *, const struct pkt *);
+  void (*B_input)(struct sim *, const struct pkt *);
+  void (*A_output)(struct sim *, const struct msg *);
+  void (*B_output)(struct sim *, const struct msg *);   /* see -bidirectional */
+  void (*A_timerinterrupt)(struct sim *);
+  void (*B_timerinterrupt)(struct sim *);
+};
+
+/* the protocol called name, NULL if there is none */
+extern const struct protocol *protocol_find(const char *name);
+
+/* is cfg->protocol known, and can it run cfg?  0, or -1 with a message */
+extern int protocol_check(const struct simconfig *cfg);
+
+/* bytes of state per flow cfg->protocol needs, 0 if it is not known */
+extern size_t protocol_statesize(const struct simconfig *cfg);
+
+#endif
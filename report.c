@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "sim.h"
+#include "runner.h"
+#include "report.h"
+
+/* ******************************************************************
+   Machine-readable results, see report.h
+**********************************************************************/
+
+int report_format(const struct simconfig *cfg)
+{
+  if (strcmp(cfg->format, "json") == 0)
+    return FORMAT_JSON;
+  if (strcmp(cfg->format, "csv") == 0)
+    return FORMAT_CSV;
+  return FORMAT_TEXT;
+}
+
+/* write a string as a JSON string or a CSV field */
+static void putstring(int format, const char *s)
+{
+  putchar('"');
+  for (; *s != '\0'; s++) {
+    if (*s == '"')
+      fputs(format == FORMAT_JSON ? "\\\"" : "\"\"", stdout);
+    else if (*s == '\\' && format == FORMAT_JSON)
+      fputs("\\\\", stdout);
+    else if ((unsigned char)*s < ' ' && format == FORMAT_JSON)
+      printf("\\u%04x", (unsigned char)*s);
+    else
+      putchar(*s);
+  }
+  putchar('"');
+}
+
+/* write a number; JSON has no NaN or infinity, e.g. from a mean over
+   no samples, so those are null.  x - x is 0 exactly when x is finite
+   (isfinite() is C99) */
+static void putnumber(int format, double x)
+{
+  if (format == FORMAT_JSON && !(x - x == 0.0))
+    printf("null");
+  else
+    printf("%.10g", x);
+}
+
+/* the parameters: the start of a JSON record, or the first CSV fields */
+static void putparams(int format, const struct simconfig *cfg)
+{
+  char value[CONFIG_PATHMAX];
+  int i;
+
+  if (format == FORMAT_JSON)
+    printf("{\"params\": {");
+  for (i = 0; i < config_nparams(); i++) {
+    if (i > 0)
+      printf(format == FORMAT_JSON ? ", " : ",");
+    if (format == FORMAT_JSON)
+      printf("\"%s\": ", config_paramname(i));
+    if (config_paramvalue(cfg, i, value))
+      putstring(format, value);
+    else
+      printf("%s", value);
+  }
+  printf(format == FORMAT_JSON ? "}, " : ",");
+}
+
+void report_begin(int format, int summary)
+{
+  int i, m;
+
+  if (format != FORMAT_CSV)
+    return;
+  for (i = 0; i < config_nparams(); i++)
+    printf("%s,", config_paramname(i));
+  for (m = 0; m < NMETRICS; m++) {
+    if (summary)
+      printf("%s_mean,%s_stddev,%s_ci95", runner_metric_key(m),
+             runner_metric_key(m), runner_metric_key(m));
+    else
+      printf("%s", runner_metric_key(m));
+    putchar(m + 1 < NMETRICS ? ',' : '\n');
+  }
+}
+
+void report_run(int format, const struct simconfig *cfg, const struct sim_results *res)
+{
+  int m;
+
+  putparams(format, cfg);
+  if (format == FORMAT_JSON)
+    printf("\"results\": {");
+  for (m = 0; m < NMETRICS; m++) {
+    if (format == FORMAT_JSON)
+      printf("\"%s\": ", runner_metric_key(m));
+    putnumber(format, runner_metric(res, m));
+    if (m + 1 < NMETRICS)
+      printf(format == FORMAT_JSON ? ", " : ",");
+  }
+  printf(format == FORMAT_JSON ? "}}\n" : "\n");
+}
+
+void report_summary(int format, const struct simconfig *cfg,
+                    const struct sim_results *res, int n)
+{
+  struct summary sum;
+  int m;
+
+  putparams(format, cfg);
+  if (format == FORMAT_JSON)
+    printf("\"results\": {");
+  for (m = 0; m < NMETRICS; m++) {
+    runner_summarise(res, n, m, &sum);
+    if (format == FORMAT_JSON)
+      printf("\"%s\": {\"mean\": ", runner_metric_key(m));
+    putnumber(format, sum.mean);
+    printf(format == FORMAT_JSON ? ", \"stddev\": " : ",");
+    putnumber(format, sum.stddev);
+    printf(format == FORMAT_JSON ? ", \"ci95\": " : ",");
+    putnumber(format, sum.ci95);
+    if (format == FORMAT_JSON)
+      putchar('}');
+    if (m + 1 < NMETRICS)
+      printf(format == FORMAT_JSON ? ", " : ",");
+  }
+  printf(format == FORMAT_JSON ? "}}\n" : "\n");
+}
@@ -0,0 +1,43 @@
+/* ******************************************************************
+   Machine-readable results.
+
+   With -format json or -format csv the human readable report is
+   replaced by one record per run, or per configuration when runs are
+   replicated or swept, holding every parameter of the configuration
+   and every statistic (see runner.h for the names).  JSON records are
+   single-line objects, one per line:
+
+       {"params": {"messages": 1000, ...}, "results": {"nlost": 97, ...}}
+
+   and summaries of several replications give each statistic as
+   {"mean": m, "stddev": s, "ci95": h}.  CSV output starts with a header
+   line; summary columns are named <statistic>_mean, _stddev and _ci95.
+   Records go to stdout a line each, so they can be piped straight into
+   analysis tools.
+**********************************************************************/
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#define FORMAT_TEXT 0
+#define FORMAT_JSON 1
+#define FORMAT_CSV  2
+
+struct simconfig;
+struct sim_results;
+
+/* FORMAT_* for cfg->format */
+extern int report_format(const struct simconfig *cfg);
+
+/* start the output: the CSV header of single run records, or of
+   summaries if summary is set */
+extern void report_begin(int format, int summary);
+
+/* one record for a single run */
+extern void report_run(int format, const struct simconfig *cfg, const struct sim_results *res);
+
+/* one record summarising the n runs in res[] of configuration cfg */
+extern void report_summary(int format, const struct simconfig *cfg,
+                           const struct sim_results *res, int n);
+
+#endif
@@ -0,0 +1,265 @@
+#define _POSIX_C_SOURCE 200112L   /* pthreads and sysconf() under -ansi */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "config.h"
+#include "sim.h"
+#include "runner.h"
+#include "report.h"
+#include "batch.h"
+
+/* ******************************************************************
+   Parallel replication runner, see runner.h
+**********************************************************************/
+
+/* one word names, after the counters they come from */
+static const char *metrickeys[NMETRICS] = {
+  "time", "nsim", "messages_delivered", "goodput", "bytes_delivered",
+  "byte_goodput", "fairness", "ntolayer3",
+  "nlost", "ncorrupt", "nqdrop", "nreorder", "nduplicate", "window_full",
+  "total_ACKs_received", "new_ACKs", "packets_resent", "packets_received",
+  "piggybacked", "latency_mean", "latency_p50", "latency_p90",
+  "latency_p99", "latency_p999", "latency_max"
+};
+
+static const char *metricnames[NMETRICS] = {
+  "simulated time",
+  "messages from layer 5",
+  "messages delivered",
+  "goodput (msgs/time unit)",
+  "payload bytes delivered",
+  "goodput (bytes/time unit)",
+  "fairness index",
+  "packets sent to layer 3",
+  "packets lost",
+  "packets corrupted",
+  "link buffer drops",
+  "packets reordered",
+  "packets duplicated",
+  "window full drops",
+  "ACKs received at A",
+  "new ACKs at A",
+  "packets resent by A",
+  "packets received at B",
+  "ACKs carried by data",
+  "latency mean",
+  "latency p50",
+  "latency p90",
+  "latency p99",
+  "latency p99.9",
+  "latency max"
+};
+
+/* what the workers share; next is the only field written while they
+   run, and each run writes only its own slots of snaps[] and res[].
+   Run j is replication j % replications of configuration
+   j / replications; in the prefix phase run j is replication j of the
+   base configuration up to base->forkat. */
+struct workqueue {
+  const struct simconfig *base;
+  const struct simconfig *cfgs;
+  int replications;         /* runs per configuration */
+  int njobs;                /* runs in this phase */
+  int prefix;               /* running the common prefixes */
+  struct snapshot **snaps;  /* a prefix per replication, or NULL */
+  struct sim_results *res;  /* one slot per run */
+  int next;                 /* next run to hand out */
+  pthread_mutex_t lock;
+};
+
+const char *runner_metric_name(int m)
+{
+  return metricnames[m];
+}
+
+const char *runner_metric_key(int m)
+{
+  return metrickeys[m];
+}
+
+double runner_metric(const struct sim_results *res, int m)
+{
+  switch (m) {
+  case M_TIME:      return res->time;
+  case M_NSIM:      return res->nsim;
+  case M_DELIVERED: return res->messages_delivered;
+  case M_GOODPUT:   return res->time > 0.0 ? res->messages_delivered / res->time : 0.0;
+  case M_BYTES:     return res->bytes_delivered;
+  case M_BYTEGOODPUT: return res->time > 0.0 ? res->bytes_delivered / res->time : 0.0;
+  case M_FAIRNESS:  return res->fairness;
+  case M_TOLAYER3:  return res->ntolayer3;
+  case M_LOST:      return res->nlost;
+  case M_CORRUPT:   return res->ncorrupt;
+  case M_QDROP:     return res->nqdrop;
+  case M_REORDER:   return res->nreorder;
+  case M_DUP:       return res->nduplicate;
+  case M_WINFULL:   return res->window_full;
+  case M_ACKS:      return res->total_ACKs_received;
+  case M_NEWACKS:   return res->new_ACKs;
+  case M_RESENT:    return res->packets_resent;
+  case M_RECEIVED:  return res->packets_received;
+  case M_PIGGYBACK: return res->piggybacked;
+  case M_LATMEAN:   return res->latmean;
+  case M_LATP50:    return res->latp50;
+  case M_LATP90:    return res->latp90;
+  case M_LATP99:    return res->latp99;
+  case M_LATP999:   return res->latp999;
+  default:          return res->latmax;
+  }
+}
+
+/* take runs from the queue until there are none left */
+static void *worker(void *arg)
+{
+  struct workqueue *wq = arg;
+  struct simconfig cfg;
+  struct sim *sim;
+  int j, r;
+
+  while (1) {
+    pthread_mutex_lock(&wq->lock);
+    j = wq->next++;
+    pthread_mutex_unlock(&wq->lock);
+    if (j >= wq->njobs)
+      return NULL;
+    r = wq->prefix ? j : j % wq->replications;
+    cfg = wq->prefix ? *wq->base : wq->cfgs[j / wq->replications];
+    cfg.replica += r;
+    cfg.bintrace[0] = '\0';
+    cfg.samplefile[0] = '\0';
+    if (wq->prefix) {
+      sim = sim_create(&cfg);
+      sim_run_until(sim, cfg.forkat);
+      wq->snaps[r] = sim_snapshot(sim);
+      sim_destroy(sim);
+      continue;
+    }
+    sim = (wq->snaps != NULL) ? sim_fork(wq->snaps[r], &cfg) : sim_create(&cfg);
+    sim_run(sim);
+    sim_results(sim, &wq->res[j]);
+    sim_destroy(sim);
+  }
+}
+
+static int cpucount(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (n > 0)
+    return (int)n;
+#endif
+  return 1;
+}
+
+/* run the queue's jobs on nthreads threads, the calling one included;
+   if a thread cannot be created the others do its share */
+static void runpool(struct workqueue *wq, int nthreads)
+{
+  pthread_t *tids;
+  int started, i;
+
+  if (nthreads > wq->njobs)
+    nthreads = wq->njobs;
+  wq->next = 0;
+  tids = malloc((nthreads > 1 ? nthreads - 1 : 1) * sizeof(pthread_t));
+  started = 0;
+  if (tids != NULL)
+    for (i = 0; i < nthreads - 1; i++) {
+      if (pthread_create(&tids[started], NULL, worker, wq) != 0)
+        break;
+      started++;
+    }
+  worker(wq);
+  for (i = 0; i < started; i++)
+    pthread_join(tids[i], NULL);
+  free(tids);
+}
+
+void runner_replicate(const struct simconfig *base, const struct simconfig *cfgs,
+                      int ncfgs, struct sim_results *res)
+{
+  struct workqueue wq;
+  int nthreads, r;
+
+  wq.base = base;
+  wq.cfgs = cfgs;
+  wq.replications = base->replications;
+  wq.snaps = NULL;
+  wq.res = res;
+  pthread_mutex_init(&wq.lock, NULL);
+  nthreads = base->threads > 0 ? base->threads : cpucount();
+
+  if (base->forkat > 0.0) {     /* the common prefix of each replication */
+    wq.snaps = malloc(wq.replications * sizeof(struct snapshot *));
+    if (wq.snaps == NULL) {
+      printf("memory allocation for snapshots failed.");
+      exit(EXIT_FAILURE);
+    }
+    wq.prefix = 1;
+    wq.njobs = wq.replications;
+    runpool(&wq, nthreads);
+  }
+
+  wq.prefix = 0;
+  wq.njobs = ncfgs * wq.replications;
+  runpool(&wq, nthreads);
+
+  if (wq.snaps != NULL) {
+    for (r = 0; r < wq.replications; r++)
+      snapshot_free(wq.snaps[r]);
+    free(wq.snaps);
+  }
+  pthread_mutex_destroy(&wq.lock);
+}
+
+void runner_summarise(const struct sim_results *res, int n, int m, struct summary *sum)
+{
+  double x, mean = 0.0, ss = 0.0;
+  int i;
+
+  /* Welford's update, stable for long runs of similar values */
+  for (i = 0; i < n; i++) {
+    x = runner_metric(&res[i], m);
+    ss += (x - mean) * (x - mean) * i / (i + 1);
+    mean += (x - mean) / (i + 1);
+  }
+  sum->mean = mean;
+  sum->stddev = n > 1 ? sqrt(ss / (n - 1)) : 0.0;
+  sum->ci95 = n > 1 ? batch_tcrit95(n - 1) * sum->stddev / sqrt((double)n) : 0.0;
+}
+
+void runner_run(const struct simconfig *cfg)
+{
+  struct sim_results *res;
+  struct summary sum;
+  int m;
+
+  res = malloc(cfg->replications * sizeof(struct sim_results));
+  if (res == NULL) {
+    printf("memory allocation for replications failed.");
+    exit(EXIT_FAILURE);
+  }
+  runner_replicate(cfg, cfg, 1, res);
+
+  if (report_format(cfg) != FORMAT_TEXT) {
+    report_begin(report_format(cfg), 1);
+    report_summary(report_format(cfg), cfg, res, cfg->replications);
+    free(res);
+    return;
+  }
+
+  printf(" %d replications of %d msgs, loss %g, corrupt %g, lambda %g, seed %lu\n",
+         cfg->replications, cfg->nsimmax, cfg->lossprob, cfg->corruptprob,
+         cfg->lambda, cfg->seed);
+  printf("%-26s %14s %14s %14s\n", "", "mean", "std dev", "95% CI +/-");
+  for (m = 0; m < NMETRICS; m++) {
+    runner_summarise(res, cfg->replications, m, &sum);
+    printf("%-26s %14.4f %14.4f %14.4f\n", runner_metric_name(m),
+           sum.mean, sum.stddev, sum.ci95);
+  }
+  free(res);
+}
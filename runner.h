@@ -0,0 +1,83 @@
+/* ******************************************************************
+   Parallel replication runner.
+
+   A Monte Carlo experiment makes cfg->replications independent runs of
+   the same configuration.  Replication r runs with replica = the
+   configured replica + r, so it draws from its own non-overlapping
+   random streams (see rnginit() in emulator.c), and the results do not
+   depend on how many threads are used or which thread ran which
+   replication.  Replications are handed out to a pool of cfg->threads
+   threads (one per online CPU if 0); each builds its own struct sim, so
+   nothing is shared but the read-only configuration.
+
+   The end of run statistics of all replications are then summarised as
+   mean, sample standard deviation and the half-width of a 95% Student t
+   confidence interval for the mean.  TRACE output, the binary trace and
+   the time series sampler are turned off for the runs, they would only
+   interleave.
+**********************************************************************/
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+struct simconfig;
+struct sim_results;
+
+/* the statistics that are summarised, in report order */
+#define M_TIME        0     /* simulated time */
+#define M_NSIM        1     /* messages offered by layer 5 */
+#define M_DELIVERED   2     /* messages delivered to layer 5 */
+#define M_GOODPUT     3     /* messages delivered per time unit */
+#define M_BYTES       4     /* payload bytes delivered to layer 5 */
+#define M_BYTEGOODPUT 5     /* payload bytes delivered per time unit */
+#define M_FAIRNESS    6     /* Jain's index of per flow deliveries */
+#define M_TOLAYER3    7     /* packets sent into the medium */
+#define M_LOST        8
+#define M_CORRUPT     9
+#define M_QDROP      10     /* packets dropped by a full link buffer */
+#define M_REORDER    11     /* packets held back and overtaken */
+#define M_DUP        12     /* packets duplicated */
+#define M_WINFULL    13     /* messages dropped due to full window */
+#define M_ACKS       14     /* uncorrupted ACKs received at A */
+#define M_NEWACKS    15
+#define M_RESENT     16
+#define M_RECEIVED   17     /* correct packets received at B */
+#define M_PIGGYBACK  18     /* ACKs carried by data packets */
+#define M_LATMEAN    19     /* message latency, layer 5 to layer 5 */
+#define M_LATP50     20
+#define M_LATP90     21
+#define M_LATP99     22
+#define M_LATP999    23
+#define M_LATMAX     24
+#define NMETRICS     25
+
+struct summary {
+  double mean;
+  double stddev;            /* sample standard deviation */
+  double ci95;              /* half-width of the 95% confidence interval */
+};
+
+/* name of statistic m as printed in reports */
+extern const char *runner_metric_name(int m);
+
+/* one word name of statistic m, for column headings and keys */
+extern const char *runner_metric_key(int m);
+
+/* value of statistic m in one run's results */
+extern double runner_metric(const struct sim_results *res, int m);
+
+/* make base->replications runs of each of the ncfgs configurations on
+   one pool of base->threads threads.  res[] is filled with the
+   replications of cfgs[0], then those of cfgs[1] and so on.  If
+   base->forkat is set, each replication of base is first run up to that
+   time and the runs of every configuration branch from its snapshot. */
+extern void runner_replicate(const struct simconfig *base, const struct simconfig *cfgs,
+                             int ncfgs, struct sim_results *res);
+
+/* summarise statistic m over n runs */
+extern void runner_summarise(const struct sim_results *res, int n, int m, struct summary *sum);
+
+/* make the replications of cfg and print the summary on stdout */
+extern void runner_run(const struct simconfig *cfg);
+
+#endif
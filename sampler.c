@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "sampler.h"
+
+/* ******************************************************************
+   Time-series sampler ring, see sampler.h
+**********************************************************************/
+
+struct sampler {
+  struct sample *ring;      /* preallocated sample ring */
+  long capacity;            /* samples the ring holds */
+  long nextrec;             /* slot the next sample goes in */
+  long total;               /* samples recorded so far */
+  struct sample last;       /* previous sample, all zero at time 0 */
+  char *outpath;            /* file the ring is written to */
+};
+
+struct sampler *sampler_open(const char *path, long nsamples)
+{
+  struct sampler *sp;
+
+  sp = malloc(sizeof(struct sampler));
+  if (sp != NULL) {
+    sp->capacity = (nsamples > 0) ? nsamples : SAMPLER_DEFAULTRECS;
+    sp->ring = malloc(sp->capacity * sizeof(struct sample));
+    sp->outpath = malloc(strlen(path) + 1);
+  }
+  if (sp == NULL || sp->ring == NULL || sp->outpath == NULL) {
+    printf("memory allocation for sampler failed.");
+    exit(EXIT_FAILURE);
+  }
+  strcpy(sp->outpath, path);
+  sp->nextrec = 0;
+  sp->total = 0;
+  memset(&sp->last, 0, sizeof(sp->last));
+  return sp;
+}
+
+void sampler_record(struct sampler *sp, struct sample *s)
+{
+  double dt = s->time - sp->last.time;
+
+  s->goodput = dt > 0.0 ? (s->delivered - sp->last.delivered) / dt : 0.0;
+  s->bytegoodput = dt > 0.0 ? (s->bytes - sp->last.bytes) / dt : 0.0;
+  s->throughput = dt > 0.0 ? (s->sent - sp->last.sent) / dt : 0.0;
+  sp->last = *s;
+
+  sp->ring[sp->nextrec] = *s;
+  if (++sp->nextrec == sp->capacity)
+    sp->nextrec = 0;
+  sp->total++;
+}
+
+void sampler_close(struct sampler *sp)
+{
+  const struct sample *s;
+  FILE *fp;
+  long n, first, i;
+
+  fp = fopen(sp->outpath, "w");
+  if (fp == NULL) {
+    printf("unable to open sample file %s\n", sp->outpath);
+    exit(EXIT_FAILURE);
+  }
+  n = (sp->total < sp->capacity) ? sp->total : sp->capacity;
+  /* oldest sample is at nextrec once the ring has wrapped */
+  first = (sp->total < sp->capacity) ? 0 : sp->nextrec;
+  fprintf(fp, "# %ld samples, %ld dropped\n", n, sp->total - n);
+  fprintf(fp, "# time delivered bytes sent resent inflight goodput bytegoodput throughput\n");
+  for (i = 0; i < n; i++) {
+    s = &sp->ring[(first + i) % sp->capacity];
+    fprintf(fp, "%f %ld %ld %ld %ld %ld %f %f %f\n", s->time, s->delivered,
+            s->bytes, s->sent, s->resent, s->inflight, s->goodput,
+            s->bytegoodput, s->throughput);
+  }
+  if (ferror(fp) || fclose(fp) != 0) {
+    printf("error writing sample file %s\n", sp->outpath);
+    exit(EXIT_FAILURE);
+  }
+
+  free(sp->ring);
+  free(sp->outpath);
+  free(sp);
+}
@@ -0,0 +1,48 @@
+/* ******************************************************************
+   Time-series sampler.
+
+   When enabled, the emulator's main loop takes a sample of its running
+   counters every cfg->sampleinterval time units of simulated time, just
+   before the first event at or after each sample time, so a sample
+   shows the state between events.  Samples go into a ring allocated up
+   front; if it wraps only the newest are kept.  The ring is written out
+   as a text table when the simulation ends, one line per sample:
+
+       time delivered bytes sent resent inflight goodput bytegoodput throughput
+
+   The first six are cumulative (inflight is the number of packets in
+   the medium), the last three are rates over the preceding interval:
+   messages and bytes delivered and packets sent into layer 3 per time
+   unit.
+**********************************************************************/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#define SAMPLER_DEFAULTRECS 65536L   /* default ring size in samples */
+
+struct sample {
+  double time;              /* simulated time of the sample */
+  long delivered;           /* messages delivered to layer 5 */
+  long bytes;               /* payload bytes delivered to layer 5 */
+  long sent;                /* packets sent into layer 3 */
+  long resent;              /* packets retransmitted by the protocol */
+  long inflight;            /* packets in the medium */
+  double goodput;           /* messages delivered per time unit */
+  double bytegoodput;       /* bytes delivered per time unit */
+  double throughput;        /* packets sent per time unit */
+};
+
+struct sampler;
+
+/* start sampling into a ring of nsamples, written to path when closed */
+extern struct sampler *sampler_open(const char *path, long nsamples);
+
+/* add a sample; only the cumulative fields need be filled in, the rates
+   are worked out from the previous sample */
+extern void sampler_record(struct sampler *sp, struct sample *s);
+
+/* write the ring out oldest first and free it */
+extern void sampler_close(struct sampler *sp);
+
+#endif
@@ -0,0 +1,92 @@
+/* ******************************************************************
+   Driving a simulation.
+
+   All emulator and protocol state for one run lives in a struct sim,
+   so any number of runs can exist side by side in one process, each
+   on its own thread if need be.  Only the TRACE level and the TRACEF()
+   sink are shared by the whole process.
+**********************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+struct sim;
+struct simconfig;
+
+/* set up a run with the given parameters, ready to start */
+extern struct sim *sim_create(const struct simconfig *cfg);
+
+/* run until no events are left */
+extern void sim_run(struct sim *sim);
+
+/* run the events before time t, returns 1 if any are left */
+extern int sim_run_until(struct sim *sim, double t);
+
+/* print the end of run statistics on stdout */
+extern void sim_report(struct sim *sim);
+
+/* end of run statistics, as printed by sim_report() */
+struct sim_results {
+  double time;              /* simulated time at the end of the run */
+  int nsim;                 /* messages offered by layer 5 */
+  int messages_delivered;   /* messages delivered to layer 5 at B */
+  long bytes_delivered;     /* payload bytes in them */
+  double fairness;          /* Jain's index of the messages each flow delivered */
+  int ntolayer3;            /* packets sent into the medium */
+  int nlost;                /* packets lost by the medium */
+  int ncorrupt;             /* packets corrupted by the medium */
+  int nqdrop;               /* packets dropped by a full link buffer */
+  int nreorder;             /* packets held back and overtaken */
+  int nduplicate;           /* packets delivered twice */
+  int window_full;          /* the protocol counters, see struct protostats */
+  int total_ACKs_received;
+  int new_ACKs;
+  int packets_resent;
+  int packets_received;
+  int piggybacked;          /* ACKs carried by data packets */
+  double latmean;           /* layer 5 arrival to delivery latency */
+  double latp50, latp90, latp99, latp999, latmax;
+};
+
+/* copy out the statistics of a finished run */
+extern void sim_results(struct sim *sim, struct sim_results *res);
+
+/* release everything the run holds, writing out its binary trace */
+extern void sim_destroy(struct sim *sim);
+
+/* Snapshots.  A snapshot is a copy of everything a run has: the event
+   list, the random number streams, the statistics and the protocol
+   state.  Any number of runs can be forked from one, e.g. to share a
+   long warm-up between variants that only differ afterwards.  A fork
+   may use a different configuration (loss, lambda, messages, ...) as
+   long as the protocol state stays valid, see sim_forkable(); it
+   starts its own binary trace and sampler if that asks for them. */
+struct snapshot;
+
+/* take a snapshot of a run, free it with snapshot_free() */
+extern struct snapshot *sim_snapshot(struct sim *sim);
+
+/* the configuration the snapshotted run had */
+extern const struct simconfig *snapshot_config(const struct snapshot *snap);
+
+#define SIM_FORKNAMES 128      /* room for sim_forkable()'s list of names */
+
+/* can a run with configuration from be continued with configuration to?
+   The protocol state is set up once, for the parameters it depends on,
+   so those cannot change.  Returns 1 if it can, else 0 with the names of
+   the changed ones, space separated, in changed if that is not NULL
+   (SIM_FORKNAMES bytes) */
+extern int sim_forkable(const struct simconfig *from, const struct simconfig *to, char *changed);
+
+/* a new run carrying on from the snapshot with configuration cfg, NULL
+   with a message if cfg is not forkable from the snapshot's */
+extern struct sim *sim_fork(const struct snapshot *snap, const struct simconfig *cfg);
+
+/* write a snapshot to a file or read one back, as the same program on
+   the same kind of machine; -1 or NULL with a message on failure */
+extern int snapshot_save(const struct snapshot *snap, const char *path);
+extern struct snapshot *snapshot_load(const char *path);
+
+extern void snapshot_free(struct snapshot *snap);
+
+#endif
@@ -1,8 +1,12 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include "emulator.h"
-#include "gbn.h"
+#include "config.h"
+#include "protocol.h"
+#include "sr.h"
+#include "trace.h"
 
 /* ******************************************************************
    Go Back N protocol.  Adapted from J.F.Kurose
@@ -23,8 +27,8 @@
 **********************************************************************/
 
 #define RTT  16.0       /* round trip time.  MUST BE SET TO 16.0 when submitting assignment */
-#define WINDOWSIZE 6    /* the maximum number of buffered unacked packet */
-#define SEQSPACE 16      /* the min sequence space for Selective Repeat must be at least windowsize * 2 */
+#define WINDOWSIZE 6    /* default maximum number of buffered unacked packet, see -window */
+#define SEQSPACE 16      /* default sequence space, see -seqspace; for Selective Repeat it must be at least windowsize * 2 */
 #define NOTINUSE (-1)   /* used to fill header fields that are not being used */
 #define WINDOWFULLBUFFERSIZE 100
 
@@ -33,78 +37,247 @@
    original checksum.  This procedure must generate a different checksum to the original if
    the packet is corrupted.
 */
-int ComputeChecksum(struct pkt packet)
+static int ComputeChecksum(const struct pkt *packet)
 {
   int checksum = 0;
   int i;
 
-  checksum = packet.seqnum;
-  checksum += packet.acknum;
-  for ( i=0; i<20; i++ ) 
-    checksum += (int)(packet.payload[i]);
+  checksum = packet->seqnum;
+  checksum += packet->acknum;
+  for ( i=0; i<packet->length; i++ ) 
+    checksum += (int)(packet->payload[i]);
 
   return checksum;
 }
 
-bool IsCorrupted(struct pkt packet)
+static bool IsCorrupted(const struct pkt *packet)
 {
-  if (packet.checksum == ComputeChecksum(packet))
+  if (packet->checksum == ComputeChecksum(packet))
     return (false);
   else
     return (true);
 }
 
 
-/********* Sender (A) variables and functions ************/
+/* window and sequence space of a run: as configured, or the defaults */
+static int cfgwindow(const struct simconfig *cfg)
+{
+  return cfg->windowsize > 0 ? cfg->windowsize : WINDOWSIZE;
+}
 
-/* Buffer needs to be of len SEQSPACE for proper implementation */
-static struct pkt buffer[SEQSPACE];  /* array for storing packets waiting for ACK */
-static int windowfirst;            /* the number of packets currently awaiting an ACK */
-static int A_nextseqnum;               /* the next sequence number to be used by the sender */
-static bool isAcked[SEQSPACE];
+static int cfgseqspace(const struct simconfig *cfg)
+{
+  if (cfg->seqspace > 0)
+    return cfg->seqspace;
+  return 2 * cfgwindow(cfg) > SEQSPACE ? 2 * cfgwindow(cfg) : SEQSPACE;
+}
 
-/* called from layer 5 (application layer), passed the message to be sent to other side */
-void A_output(struct msg message)
+static int check(const struct simconfig *cfg)
+{
+  if (cfgwindow(cfg) < 1 || cfgseqspace(cfg) < 2 * cfgwindow(cfg)) {
+    fprintf(stderr, "Selective Repeat needs window >= 1 and seqspace >= 2 * window\n");
+    return -1;
+  }
+  return 0;
+}
+
+struct sr_sender {
+  int windowfirst;            /* the number of packets currently awaiting an ACK */
+  int nextseqnum;             /* the next sequence number to be used by the sender */
+  float rtxdue;               /* bidirectional: when the oldest packet times out, -1 if none */
+  bool timing;                /* bidirectional: the entity's timer is running */
+};
+
+struct sr_receiver {
+  int buffer_start;           /* the oldest sequence number not yet delivered */
+  int pendingack;             /* bidirectional: ACK waiting for data to carry it, or NOTINUSE */
+  float ackdue;               /* when it has to go by itself */
+};
+
+/* the state the emulator keeps for each simulation.  Each entity is a
+   sender and a receiver, though without bidirectional transfer only A
+   sends and only B receives.  The struct is followed in the same block
+   by three arrays of seqspace entries per entity: the buffers of
+   packets waiting for ACK, the receive buffers and the isAcked flags.
+   Buffers need to be of len seqspace for proper implementation.  Their
+   packets are pktsize bytes apart, room for the run's payload and no
+   more.  The block holds no pointers, so it stays valid wherever it is
+   copied. */
+struct sr_state {
+  int windowsize;
+  int seqspace;
+  int pktsize;                /* PKTSIZE() of the run's payload */
+  int acklength;              /* payload bytes of an ACK */
+  bool bidirectional;         /* B sends data too, and ACKs ride on data */
+  float ackdelay;             /* longest an ACK waits for data to carry it */
+  struct sr_sender sender[2];
+  struct sr_receiver receiver[2];
+};
+
+#define STATE(sim)          ((struct sr_state *)sim_state(sim))
+#define SENDER(sim, e)      (&STATE(sim)->sender[e])
+#define RECEIVER(sim, e)    (&STATE(sim)->receiver[e])
+#define SLOT(sim, n)        ((struct pkt *)((char *)(STATE(sim) + 1) + (n) * STATE(sim)->pktsize))
+#define BUFFER(sim, e, i)   SLOT(sim, (e) * STATE(sim)->seqspace + (i))
+#define RCVBUFFER(sim, e, i) SLOT(sim, (2 + (e)) * STATE(sim)->seqspace + (i))
+#define ISACKED(sim, e)     ((bool *)SLOT(sim, 4 * STATE(sim)->seqspace) + (e) * STATE(sim)->seqspace)
+#define NAME(e)             ((e) == A ? 'A' : 'B')
+
+static size_t statesize(const struct simconfig *cfg)
+{
+  return sizeof(struct sr_state)
+    + 2 * cfgseqspace(cfg) * (2 * PKTSIZE(cfg->payload) + sizeof(bool));
+}
+
+/* record the run's parameters, from A_init() and B_init() */
+static void setup(struct sim *sim)
+{
+  STATE(sim)->windowsize = cfgwindow(sim_config(sim));
+  STATE(sim)->seqspace = cfgseqspace(sim_config(sim));
+  STATE(sim)->pktsize = PKTSIZE(sim_config(sim)->payload);
+  STATE(sim)->acklength = sim_config(sim)->payload < 20 ? sim_config(sim)->payload : 20;
+  STATE(sim)->bidirectional = sim_config(sim)->bidirectional;
+  STATE(sim)->ackdelay = sim_config(sim)->ackdelay;
+}
+
+
+/********* Timers ************/
+
+/* With bidirectional transfer an entity's one timer serves both its
+   oldest unacknowledged packet and its pending ACK, so it is set for
+   whichever is due first.  Otherwise it only ever times packets. */
+static void rearm(struct sim *sim, int e)
+{
+  struct sr_sender *s = SENDER(sim, e);
+  struct sr_receiver *r = RECEIVER(sim, e);
+  double due = s->rtxdue;
+
+  if (r->pendingack != NOTINUSE && (due < 0 || r->ackdue < due))
+    due = r->ackdue;
+  if (s->timing)
+    stoptimer(sim, e);
+  s->timing = (due >= 0);
+  if (s->timing)
+    starttimer(sim, e, due > sim_time(sim) ? due - sim_time(sim) : 0.0);
+}
+
+/* time the oldest packet in e's window */
+static void rtxstart(struct sim *sim, int e)
 {
-  struct pkt sendpkt;
+  if (!STATE(sim)->bidirectional) {
+    starttimer(sim, e, RTT);
+    return;
+  }
+  SENDER(sim, e)->rtxdue = sim_time(sim) + RTT;
+  rearm(sim, e);
+}
+
+static void rtxstop(struct sim *sim, int e)
+{
+  if (!STATE(sim)->bidirectional) {
+    stoptimer(sim, e);
+    return;
+  }
+  SENDER(sim, e)->rtxdue = -1;
+  rearm(sim, e);
+}
+
+
+/********* ACKs ************/
+
+/* send an ACK on its own, the payload filled with fill */
+static void sendack(struct sim *sim, int e, int acknum, char fill)
+{
+  struct pkt ackpkt;
   int i;
 
-  /* if valid window */
-  if (windowfirst + WINDOWSIZE > A_nextseqnum) {
-    if (TRACE > 1)
-      printf("----A: New message arrives, send window is not full, send new messge to layer3!\n");
-
-    /* create packet */
-    sendpkt.seqnum = A_nextseqnum;
-    sendpkt.acknum = NOTINUSE;
-    for ( i=0; i<20 ; i++ ) 
-      sendpkt.payload[i] = message.data[i];
-    sendpkt.checksum = ComputeChecksum(sendpkt); 
-
-    /* put packet in window buffer */
-    buffer[A_nextseqnum % SEQSPACE] = sendpkt;
-    if (TRACE > 0)
-      printf("Sending packet %d to layer 3\n", sendpkt.seqnum);
+  ackpkt.seqnum = NOTINUSE;
+  ackpkt.acknum = acknum;
+  ackpkt.length = STATE(sim)->acklength;
+  for (i = 0; i < ackpkt.length; i++)
+    ackpkt.payload[i] = fill;
+  ackpkt.checksum = ComputeChecksum(&ackpkt);
+  tolayer3(sim, e, &ackpkt);
+}
+
+/* acknowledge seqnum.  With bidirectional transfer the ACK waits up to
+   ackdelay for a data packet to carry it; only one waits at a time, so
+   an earlier one still waiting goes now. */
+static void ack(struct sim *sim, int e, int seqnum, char fill)
+{
+  struct sr_receiver *r = RECEIVER(sim, e);
+
+  if (!STATE(sim)->bidirectional || STATE(sim)->ackdelay <= 0) {
+    sendack(sim, e, seqnum, fill);
+    return;
+  }
+  if (r->pendingack != NOTINUSE)
+    sendack(sim, e, r->pendingack, '0');
+  r->pendingack = seqnum;
+  r->ackdue = sim_time(sim) + STATE(sim)->ackdelay;
+  rearm(sim, e);
+}
+
+/* the ACK a data packet from e carries: the one waiting, if any */
+static int piggyback(struct sim *sim, int e)
+{
+  struct sr_receiver *r = RECEIVER(sim, e);
+  int acknum = r->pendingack;
+
+  if (acknum != NOTINUSE) {
+    TRACEF(2, ("----%c: ACK %d rides on the data packet\n", NAME(e), acknum));
+    sim_stats(sim)->piggybacked++;
+    r->pendingack = NOTINUSE;
+  }
+  return acknum;
+}
+
+
+/********* Sender variables and functions ************/
+
+/* called from layer 5 (application layer), passed the message to be sent to other side */
+static void output(struct sim *sim, int e, const struct msg *message)
+{
+  struct sr_sender *s = SENDER(sim, e);
+  int seqspace = STATE(sim)->seqspace;
+  struct pkt *sendpkt;
+
+  /* if valid window: fewer than windowsize packets awaiting an ACK,
+     counted modulo seqspace so it holds when the numbers wrap */
+  if ((s->nextseqnum - s->windowfirst + seqspace) % seqspace < STATE(sim)->windowsize) {
+    TRACEF(2, ("----%c: New message arrives, send window is not full, send new messge to layer3!\n", NAME(e)));
+
+    /* create packet, in its place in the window buffer */
+    sendpkt = BUFFER(sim, e, s->nextseqnum % seqspace);
+    sendpkt->seqnum = s->nextseqnum;
+    sendpkt->acknum = STATE(sim)->bidirectional ? piggyback(sim, e) : NOTINUSE;
+    sendpkt->length = message->length;
+    memcpy(sendpkt->payload, message->data, message->length);
+    sendpkt->checksum = ComputeChecksum(sendpkt); 
+
+    TRACEF(1, ("Sending packet %d to layer 3\n", sendpkt->seqnum));
     /* send out packet */
-    tolayer3 (A, sendpkt);
+    tolayer3(sim, e, sendpkt);
 
-    if (A_nextseqnum == windowfirst) {
+    if (s->nextseqnum == s->windowfirst) {
       /* start timer if first packet in window */
-      starttimer(A,RTT);
+      rtxstart(sim, e);
+    }
+    else if (sendpkt->acknum != NOTINUSE) {
+      /* the ACK it carried no longer needs the timer */
+      rearm(sim, e);
     }
 
-    A_nextseqnum = (A_nextseqnum + 1) % SEQSPACE;
+    s->nextseqnum = (s->nextseqnum + 1) % seqspace;
 
   } else {
-    if (TRACE > 0) {
-      printf("----A: New message arrives, send window is full\n");
-    }
-    window_full++;
+    TRACEF(1, ("----%c: New message arrives, send window is full\n", NAME(e)));
+    sim_stats(sim)->window_full++;
   }
 }
 
 /* check if sequence number is within window */
-bool is_within_window(int seqnum, int start, int end) {
+static bool is_within_window(int seqnum, int start, int end) {
   /* Both cases of being fully within window or wrapping around */
   if (start <= end) {
       /* If fully within window, check if between both */
@@ -115,202 +288,256 @@ bool is_within_window(int seqnum, int start, int end) {
   }
 }
 
-/* called from layer 3, when a packet arrives for layer 4 
-   In this practical this will always be an ACK as B never sends data.
-*/
-void A_input(struct pkt packet)
+/* called when an ACK arrives at e, on its own or carried by data */
+static void ackinput(struct sim *sim, int e, const struct pkt *packet)
 {
+  struct sr_sender *s = SENDER(sim, e);
+  bool *isAcked = ISACKED(sim, e);
+
   if (IsCorrupted(packet)) {
-    if (TRACE > 0) {
-      printf("----A: corrupted ACK is received, do nothing!\n");
-    }
+    TRACEF(1, ("----%c: corrupted ACK is received, do nothing!\n", NAME(e)));
     return;
   }
 
-  total_ACKs_received += 1;
-  if (TRACE > 0) {
-    printf("----A: uncorrupted ACK %d is received\n",packet.acknum);
-  }
+  sim_stats(sim)->total_ACKs_received += 1;
+  TRACEF(1, ("----%c: uncorrupted ACK %d is received\n", NAME(e), packet->acknum));
 
   /* Check if ACK is in window */
-  if (!is_within_window(packet.acknum, windowfirst, A_nextseqnum)) {
+  if (!is_within_window(packet->acknum, s->windowfirst, s->nextseqnum)) {
     return;
   }
 
   /* Check if ACK is already received and is duplicate */
-  if (isAcked[packet.acknum]) {
-    if (TRACE > 0) {
-      printf("----A: duplicate ACK %d, do nothing!\n", packet.acknum);
-    }
+  if (isAcked[packet->acknum]) {
+    TRACEF(1, ("----%c: duplicate ACK %d, do nothing!\n", NAME(e), packet->acknum));
     return;
   }
    
-  new_ACKs++;
+  sim_stats(sim)->new_ACKs++;
   
-  if (TRACE > 0) {
-    printf("----A: ACK %d is not a duplicate\n", packet.acknum);
-  }
+  TRACEF(1, ("----%c: ACK %d is not a duplicate\n", NAME(e), packet->acknum));
   
-  isAcked[packet.acknum] = true;
+  isAcked[packet->acknum] = true;
 
-  if (packet.acknum == windowfirst) {
-    stoptimer(A);
+  if (packet->acknum == s->windowfirst) {
+    rtxstop(sim, e);
     /* Go to next unacked packet */
-    while (windowfirst != A_nextseqnum && isAcked[windowfirst]) {
-      isAcked[windowfirst] = false;
-      windowfirst = (windowfirst + 1) % SEQSPACE;
+    while (s->windowfirst != s->nextseqnum && isAcked[s->windowfirst]) {
+      isAcked[s->windowfirst] = false;
+      s->windowfirst = (s->windowfirst + 1) % STATE(sim)->seqspace;
     }
 
-    if (windowfirst != A_nextseqnum) {
-      starttimer(A, RTT);
+    if (s->windowfirst != s->nextseqnum) {
+      rtxstart(sim, e);
     }
   }
 
 }
 
-/* called when A's timer goes off */
-void A_timerinterrupt(void)
+/* called when e's timer goes off: resend the oldest packet, or with
+   bidirectional transfer send the waiting ACK if that was due first */
+static void timerinterrupt(struct sim *sim, int e)
 {
-  struct pkt send_pkt;
+  struct sr_sender *s = SENDER(sim, e);
+  struct sr_receiver *r = RECEIVER(sim, e);
+  struct pkt *send_pkt;
+
+  if (STATE(sim)->bidirectional) {
+    s->timing = false;
+    if (r->pendingack != NOTINUSE && (s->rtxdue < 0 || r->ackdue <= s->rtxdue)) {
+      TRACEF(1, ("----%c: no data to carry ACK %d, sending it alone\n", NAME(e), r->pendingack));
+      sendack(sim, e, r->pendingack, '0');
+      r->pendingack = NOTINUSE;
+      rearm(sim, e);
+      return;
+    }
+    if (s->rtxdue < 0) {
+      return;
+    }
+  }
   
-  send_pkt = buffer[windowfirst];
+  send_pkt = BUFFER(sim, e, s->windowfirst);
+
+  TRACEF(1, ("----%c: time out,resend packets!\n", NAME(e)));
+  TRACEF(1, ("---%c: resending packet %d\n", NAME(e), (send_pkt->seqnum)));
 
-  if (TRACE > 0) {
-    printf("----A: time out,resend packets!\n");
-    printf("---A: resending packet %d\n", (send_pkt.seqnum));
+  /* the ACK it carried when first sent may be a whole sequence space
+     old by now and would be taken for a new one; carry the one waiting
+     instead, if any */
+  if (STATE(sim)->bidirectional) {
+    send_pkt->acknum = piggyback(sim, e);
+    send_pkt->checksum = ComputeChecksum(send_pkt);
   }
 
   /* Singular packet sending only instead of GBN's for loop as sends packets individually instead of all after */
-  tolayer3(A, send_pkt);
-  packets_resent++;
-  starttimer(A, RTT);
+  tolayer3(sim, e, send_pkt);
+  sim_stats(sim)->packets_resent++;
+  rtxstart(sim, e);
 }       
 
 
+/********* Receiver variables and procedures ************/
 
-/* the following routine will be called once (only) before any other */
-/* entity A routines are called. You can use it to do any initialization */
-void A_init(void)
-{
-  int i;
-  /* initialise A's window, buffer and sequence number */
-  A_nextseqnum = 0; 
-  windowfirst = 0;
-
-  for (i = 0; i < SEQSPACE; i++) {
-    isAcked[i] = false;
-  }
-}
-
-
-
-/********* Receiver (B)  variables and procedures ************/
-
-static int expectedseqnum; /* the sequence number expected next by the receiver */
-static int B_nextseqnum;   /* the sequence number for the next packets sent by B */
-static struct pkt buffer_B_side[SEQSPACE];
-static int buffer_B_start;
-
-/* called from layer 3, when a packet arrives for layer 4 at B*/
-void B_input(struct pkt packet)
+/* called when a data packet arrives at e */
+static void datainput(struct sim *sim, int e, const struct pkt *packet)
 {
-  struct pkt buffer_pkt;
-  int i;
+  struct sr_receiver *s = RECEIVER(sim, e);
+  int windowsize = STATE(sim)->windowsize;
+  int seqspace = STATE(sim)->seqspace;
+  struct pkt *buffer_pkt;
 
   bool currWindow = false;
-  int left = buffer_B_start;
-  int right = (buffer_B_start + WINDOWSIZE) % SEQSPACE;
+  int left = s->buffer_start;
+  int right = (s->buffer_start + windowsize) % seqspace;
 
   bool prevWindow = false;
-  int prevLeft = (buffer_B_start + SEQSPACE - WINDOWSIZE) % SEQSPACE;
-  int prevRight = buffer_B_start;
+  int prevLeft = (s->buffer_start + seqspace - windowsize) % seqspace;
+  int prevRight = s->buffer_start;
 
   /* Check if packet is corrupted */
   if (IsCorrupted(packet)) {
     return;
   }
 
-  if (TRACE > 0)
-    printf("----B: packet %d is correctly received, send ACK!\n",packet.seqnum);
-  packets_received++;
+  TRACEF(1, ("----%c: packet %d is correctly received, send ACK!\n", NAME(e), packet->seqnum));
+  sim_stats(sim)->packets_received++;
 
   /* Check if packet is in current window */
-  currWindow = is_within_window(packet.seqnum, left, right);
+  currWindow = is_within_window(packet->seqnum, left, right);
 
   if (currWindow) {
-    struct pkt packet_return;
-    packet_return.seqnum = NOTINUSE;
-    packet_return.acknum = packet.seqnum;
-
-    /* Fill with blank data and compute checksum */
-    for (i = 0; i < 20; i++) {
-      packet_return.payload[i] = '0';
-    }
-    packet_return.checksum = ComputeChecksum(packet_return);
-
-    tolayer3(B, packet_return);
+    ack(sim, e, packet->seqnum, '0');
 
-    buffer_pkt = buffer_B_side[packet.seqnum];
+    buffer_pkt = RCVBUFFER(sim, e, packet->seqnum);
 
-    if (buffer_pkt.seqnum == NOTINUSE) {
-      buffer_B_side[packet.seqnum] = packet;
+    if (buffer_pkt->seqnum == NOTINUSE) {
+      pkt_copy(buffer_pkt, packet);
     }
 
     /* Slide window forward */
-    while (buffer_B_side[buffer_B_start].seqnum != NOTINUSE) {
-      tolayer5(B, buffer_B_side[buffer_B_start].payload);
-      buffer_B_side[buffer_B_start].seqnum = NOTINUSE;
-      buffer_B_start = (buffer_B_start + 1) % SEQSPACE;
+    while ((buffer_pkt = RCVBUFFER(sim, e, s->buffer_start))->seqnum != NOTINUSE) {
+      tolayer5(sim, e, buffer_pkt->payload, buffer_pkt->length);
+      buffer_pkt->seqnum = NOTINUSE;
+      s->buffer_start = (s->buffer_start + 1) % seqspace;
   }
     return;
   }
 
   /* Prev window is checked as per course reading to check if ACK must be generated */
-  prevWindow = is_within_window(packet.seqnum, prevLeft, prevRight);
+  prevWindow = is_within_window(packet->seqnum, prevLeft, prevRight);
   
   if (prevWindow) {
-    struct pkt prev_buffer_pkt;
-    prev_buffer_pkt.seqnum = NOTINUSE;
-    prev_buffer_pkt.acknum = packet.seqnum;
-    for (i = 0; i < 20; i++) {
-      prev_buffer_pkt.payload[i] = 'A';
-    }
-    prev_buffer_pkt.checksum = ComputeChecksum(prev_buffer_pkt);
-    tolayer3(B, prev_buffer_pkt);
+    ack(sim, e, packet->seqnum, 'A');
   }
   /* Ignore packet otherwise if not in previous either */
 }
+
+/* called from layer 3, when a packet arrives for layer 4 at e.  Without
+   bidirectional transfer A only gets ACKs and B only data; otherwise a
+   packet may carry an ACK (acknum), data (seqnum) or both. */
+static void input(struct sim *sim, int e, const struct pkt *packet)
+{
+  if (!STATE(sim)->bidirectional) {
+    if (e == A)
+      ackinput(sim, e, packet);
+    else
+      datainput(sim, e, packet);
+    return;
+  }
+  if (IsCorrupted(packet)) {
+    TRACEF(1, ("----%c: corrupted packet is received, do nothing!\n", NAME(e)));
+    return;
+  }
+  if (packet->acknum != NOTINUSE)
+    ackinput(sim, e, packet);
+  if (packet->seqnum != NOTINUSE)
+    datainput(sim, e, packet);
+}
+
+/* set up entity e as a sender and a receiver */
+static void init(struct sim *sim, int e)
+{
+  struct sr_sender *s;
+  struct sr_receiver *r;
+  struct pkt *rcvpkt;
+  bool *isAcked;
+  int i;
+
+  setup(sim);
+  s = SENDER(sim, e);
+  r = RECEIVER(sim, e);
+  isAcked = ISACKED(sim, e);
+
+  /* initialise the window, buffer and sequence number */
+  s->nextseqnum = 0; 
+  s->windowfirst = 0;
+  s->rtxdue = -1;
+  s->timing = false;
+  for (i = 0; i < STATE(sim)->seqspace; i++) {
+    isAcked[i] = false;
+  }
+
+  r->buffer_start = 0;
+  r->pendingack = NOTINUSE;
+  r->ackdue = -1;
+  for (i = 0; i < STATE(sim)->seqspace; i++) {
+    rcvpkt = RCVBUFFER(sim, e, i);
+    rcvpkt->acknum = NOTINUSE;
+    rcvpkt->seqnum = NOTINUSE;
+    rcvpkt->length = 0;       /* empty until a packet is buffered */
+  }
+}
+
+
+/********* Entry points for A and B ************/
+
+static void A_output(struct sim *sim, const struct msg *message)
+{
+  output(sim, A, message);
+}
+
+static void A_input(struct sim *sim, const struct pkt *packet)
+{
+  input(sim, A, packet);
+}
+
+static void A_timerinterrupt(struct sim *sim)
+{
+  timerinterrupt(sim, A);
+}
+
+/* the following routine will be called once (only) before any other */
+/* entity A routines are called. You can use it to do any initialization */
+static void A_init(struct sim *sim)
+{
+  init(sim, A);
+}
+
+static void B_input(struct sim *sim, const struct pkt *packet)
+{
+  input(sim, B, packet);
+}
+
 /* the following routine will be called once (only) before any other */
 /* entity B routines are called. You can use it to do any initialization */
-void B_init(void)
+static void B_init(struct sim *sim)
 {
-  int seq_item;
-  int idx;
-  expectedseqnum = 0;
-  B_nextseqnum = 1;
-
-  buffer_B_start = 0;
-
-  for (seq_item = 0; seq_item < SEQSPACE; seq_item++) {
-    buffer_B_side[seq_item].acknum = NOTINUSE;
-    buffer_B_side[seq_item].seqnum = NOTINUSE;
-    /* fill the buffer with 0's */
-    for (idx = 0; idx < 20; idx++) {
-      buffer_B_side[seq_item].payload[idx] = '0';
-    }
-  }
+  init(sim, B);
 }
-/******************************************************************************
- * The following functions need be completed only for bi-directional messages *
- *****************************************************************************/
 
-/* Note that with simplex transfer from a-to-B, there is no B_output() */
-void B_output(struct msg message)  
+/* only called with bidirectional transfer, see -bidirectional */
+static void B_output(struct sim *sim, const struct msg *message)  
 {
+  output(sim, B, message);
 }
 
 /* called when B's timer goes off */
-void B_timerinterrupt(void)
+static void B_timerinterrupt(struct sim *sim)
 {
+  timerinterrupt(sim, B);
 }
 
+const struct protocol sr_protocol = {
+  "sr", check, statesize, A_init, B_init, A_input, B_input,
+  A_output, B_output, A_timerinterrupt, B_timerinterrupt
+};
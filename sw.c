@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "emulator.h"
+#include "config.h"
+#include "protocol.h"
+#include "sw.h"
+#include "trace.h"
+
+/* ******************************************************************
+   Stop-and-wait (alternating bit) protocol, after J.F.Kurose's
+   ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.2
+
+   A has at most one packet outstanding, numbered 0 or 1 in turn, and
+   sends the next only once B has acknowledged it; messages arriving
+   while it waits are refused.  It is Go Back N with a window of one,
+   kept separate as the baseline the windowed protocols are compared
+   with.  Only sends from A to B.
+**********************************************************************/
+
+#define RTT  16.0       /* round trip time */
+#define SEQSPACE 2      /* alternating bit */
+#define NOTINUSE (-1)   /* used to fill header fields that are not being used */
+
+/* generic procedure to compute the checksum of a packet.  Used by both sender and receiver */
+static int ComputeChecksum(const struct pkt *packet)
+{
+  int checksum;
+  int i;
+
+  checksum = packet->seqnum;
+  checksum += packet->acknum;
+  for ( i=0; i<packet->length; i++ )
+    checksum += (int)(packet->payload[i]);
+
+  return checksum;
+}
+
+static bool IsCorrupted(const struct pkt *packet)
+{
+  return packet->checksum != ComputeChecksum(packet);
+}
+
+
+static int check(const struct simconfig *cfg)
+{
+  if (cfg->windowsize > 1 || (cfg->seqspace > 0 && cfg->seqspace != SEQSPACE)) {
+    fprintf(stderr, "stop-and-wait has a window of 1 and a sequence space of 2\n");
+    return -1;
+  }
+  if (cfg->bidirectional) {
+    fprintf(stderr, "stop-and-wait only sends from A to B\n");
+    return -1;
+  }
+  return 0;
+}
+
+struct sw_sender {
+  bool waiting;       /* is the packet in the buffer awaiting its ACK? */
+  int nextseqnum;     /* the sequence number of the next new packet */
+};
+
+struct sw_receiver {
+  int expectedseqnum; /* the sequence number expected next by the receiver */
+};
+
+/* the state the emulator keeps for each simulation, followed in the
+   same block by A's one packet waiting for ACK */
+struct sw_state {
+  int acklength;                  /* payload bytes of an ACK */
+  struct sw_sender sender;
+  struct sw_receiver receiver;
+};
+
+#define STATE(sim)    ((struct sw_state *)sim_state(sim))
+#define SENDER(sim)   (&STATE(sim)->sender)
+#define RECEIVER(sim) (&STATE(sim)->receiver)
+#define BUFFER(sim)   ((struct pkt *)(STATE(sim) + 1))
+
+static size_t statesize(const struct simconfig *cfg)
+{
+  return sizeof(struct sw_state) + PKTSIZE(cfg->payload);
+}
+
+static void setup(struct sim *sim)
+{
+  STATE(sim)->acklength = sim_config(sim)->payload < 20 ? sim_config(sim)->payload : 20;
+}
+
+
+/********* Sender (A) ************/
+
+/* called from layer 5, passed the message to be sent to B */
+static void A_output(struct sim *sim, const struct msg *message)
+{
+  struct sw_sender *s = SENDER(sim);
+  struct pkt *sendpkt = BUFFER(sim);
+
+  if (s->waiting) {
+    TRACEF(1, ("----A: New message arrives, still waiting for an ACK\n"));
+    sim_stats(sim)->window_full++;
+    return;
+  }
+  sendpkt->seqnum = s->nextseqnum;
+  sendpkt->acknum = NOTINUSE;
+  sendpkt->length = message->length;
+  memcpy(sendpkt->payload, message->data, message->length);
+  sendpkt->checksum = ComputeChecksum(sendpkt);
+  s->waiting = true;
+  s->nextseqnum = (s->nextseqnum + 1) % SEQSPACE;
+
+  TRACEF(1, ("Sending packet %d to layer 3\n", sendpkt->seqnum));
+  tolayer3(sim, A, sendpkt);
+  starttimer(sim, A, RTT);
+}
+
+/* called from layer 3 with an ACK from B */
+static void A_input(struct sim *sim, const struct pkt *packet)
+{
+  struct sw_sender *s = SENDER(sim);
+
+  if (IsCorrupted(packet)) {
+    TRACEF(1, ("----A: corrupted ACK is received, do nothing!\n"));
+    return;
+  }
+  TRACEF(1, ("----A: uncorrupted ACK %d is received\n", packet->acknum));
+  sim_stats(sim)->total_ACKs_received++;
+  if (s->waiting && packet->acknum == BUFFER(sim)->seqnum) {
+    TRACEF(1, ("----A: ACK %d is not a duplicate\n", packet->acknum));
+    sim_stats(sim)->new_ACKs++;
+    s->waiting = false;
+    stoptimer(sim, A);
+  }
+  else
+    TRACEF(1, ("----A: duplicate ACK received, do nothing!\n"));
+}
+
+/* called when A's timer goes off */
+static void A_timerinterrupt(struct sim *sim)
+{
+  TRACEF(1, ("----A: time out, resend packet %d\n", BUFFER(sim)->seqnum));
+  tolayer3(sim, A, BUFFER(sim));
+  sim_stats(sim)->packets_resent++;
+  starttimer(sim, A, RTT);
+}
+
+static void A_init(struct sim *sim)
+{
+  struct sw_sender *s = SENDER(sim);
+
+  setup(sim);
+  s->waiting = false;
+  s->nextseqnum = 0;
+}
+
+
+/********* Receiver (B) ************/
+
+/* called from layer 3 with a packet from A */
+static void B_input(struct sim *sim, const struct pkt *packet)
+{
+  struct sw_receiver *s = RECEIVER(sim);
+  struct pkt sendpkt;
+  int i;
+
+  if (!IsCorrupted(packet) && packet->seqnum == s->expectedseqnum) {
+    TRACEF(1, ("----B: packet %d is correctly received, send ACK!\n", packet->seqnum));
+    sim_stats(sim)->packets_received++;
+    tolayer5(sim, B, packet->payload, packet->length);
+    sendpkt.acknum = s->expectedseqnum;
+    s->expectedseqnum = (s->expectedseqnum + 1) % SEQSPACE;
+  }
+  else {
+    /* corrupted or a resend of the last packet: ACK the last one again */
+    TRACEF(1, ("----B: packet corrupted or not expected sequence number, resend ACK!\n"));
+    sendpkt.acknum = (s->expectedseqnum + SEQSPACE - 1) % SEQSPACE;
+  }
+
+  sendpkt.seqnum = NOTINUSE;
+  sendpkt.length = STATE(sim)->acklength;
+  for ( i=0; i<sendpkt.length ; i++ )
+    sendpkt.payload[i] = '0';
+  sendpkt.checksum = ComputeChecksum(&sendpkt);
+  tolayer3(sim, B, &sendpkt);
+}
+
+static void B_init(struct sim *sim)
+{
+  setup(sim);
+  RECEIVER(sim)->expectedseqnum = 0;
+}
+
+/* stop-and-wait is simplex: no B_output() or B timer */
+static void B_output(struct sim *sim, const struct msg *message)
+{
+}
+
+static void B_timerinterrupt(struct sim *sim)
+{
+}
+
+const struct protocol sw_protocol = {
+  "sw", check, statesize, A_init, B_init, A_input, B_input,
+  A_output, B_output, A_timerinterrupt, B_timerinterrupt
+};
@@ -0,0 +1,4 @@
+/* stop-and-wait (alternating bit), see protocol.h */
+struct protocol;
+
+extern const struct protocol sw_protocol;
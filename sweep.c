@@ -0,0 +1,279 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "config.h"
+#include "sim.h"
+#include "runner.h"
+#include "sweep.h"
+#include "report.h"
+#include "emulator.h"
+#include "protocol.h"
+
+/* ******************************************************************
+   Parameter sweeps, see sweep.h
+**********************************************************************/
+
+#define NAMEMAX 32      /* longest parameter name */
+
+struct axis {
+  char name[NAMEMAX];
+  int nvalues;
+  double values[SWEEP_MAXVALUES];
+  char *words[SWEEP_MAXVALUES];   /* the values, if they are words like protocol names */
+  int isword;
+  char text[CONFIG_PATHMAX];      /* where the words are kept */
+};
+
+/* parameters that make no sense to sweep */
+static const char *fixed[] = { "sweep", "replications", "threads", "config",
+                               "forkat", "snapshot", "resume" };
+
+/* parse "w1,w2,..." into ax->words */
+static int parsewords(struct axis *ax, const char *spec)
+{
+  char *w, *comma;
+
+  strcpy(ax->text, spec);
+  ax->isword = 1;
+  ax->nvalues = 0;
+  for (w = ax->text; ; w = comma + 1) {
+    comma = strchr(w, ',');
+    if (comma != NULL)
+      *comma = '\0';
+    if (*w == '\0' || ax->nvalues == SWEEP_MAXVALUES)
+      return -1;
+    ax->words[ax->nvalues++] = w;
+    if (comma == NULL)
+      return 0;
+  }
+}
+
+/* parse "start:stop:step" or "v1,v2,..." into ax->values, or a list
+   that is not numbers into ax->words */
+static int parsevalues(struct axis *ax, const char *spec)
+{
+  double start, stop, step;
+  char *end;
+  long n, i;
+
+  ax->isword = 0;
+  start = strtod(spec, &end);
+  if (end == spec)
+    return parsewords(ax, spec);
+  if (end != spec && *end == ':') {
+    stop = strtod(end + 1, &end);
+    if (*end != ':')
+      return -1;
+    step = strtod(end + 1, &end);
+    if (*end != '\0' || step == 0.0 || (stop - start) / step < 0.0)
+      return -1;
+    /* allow for rounding so that the stop value itself is included */
+    n = (long)floor((stop - start) / step + 1e-9) + 1;
+    if (n > SWEEP_MAXVALUES)
+      return -1;
+    for (i = 0; i < n; i++)
+      ax->values[i] = start + i * step;
+    ax->nvalues = (int)n;
+    return 0;
+  }
+
+  ax->nvalues = 0;
+  while (1) {
+    if (ax->nvalues == SWEEP_MAXVALUES)
+      return -1;
+    ax->values[ax->nvalues++] = strtod(spec, &end);
+    if (end == spec || (*end != ',' && *end != '\0'))
+      return -1;
+    if (*end == '\0')
+      return 0;
+    spec = end + 1;
+  }
+}
+
+/* split cfg->sweep into axes, returns the number of axes or -1 */
+static int parseaxes(const char *sweep, struct axis *axes)
+{
+  char buf[CONFIG_PATHMAX];
+  char *tok, *eq;
+  int naxes = 0;
+  size_t i;
+
+  strcpy(buf, sweep);
+  for (tok = strtok(buf, " \t;"); tok != NULL; tok = strtok(NULL, " \t;")) {
+    eq = strchr(tok, '=');
+    if (eq == NULL || eq == tok || eq - tok >= NAMEMAX) {
+      fprintf(stderr, "sweep: expected name=values, got '%s'\n", tok);
+      return -1;
+    }
+    if (naxes == SWEEP_MAXAXES) {
+      fprintf(stderr, "sweep: at most %d parameters\n", SWEEP_MAXAXES);
+      return -1;
+    }
+    *eq = '\0';
+    for (i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++)
+      if (strcmp(tok, fixed[i]) == 0) {
+        fprintf(stderr, "sweep: %s cannot be swept\n", tok);
+        return -1;
+      }
+    strcpy(axes[naxes].name, tok);
+    if (parsevalues(&axes[naxes], eq + 1) != 0) {
+      fprintf(stderr, "sweep: bad values '%s' for %s\n", eq + 1, tok);
+      return -1;
+    }
+    naxes++;
+  }
+  if (naxes == 0) {
+    fprintf(stderr, "sweep: no parameters given\n");
+    return -1;
+  }
+  return naxes;
+}
+
+/* index of point p along axis a, the last axis varying fastest */
+static int coord(const struct axis *axes, int naxes, long p, int a)
+{
+  int k;
+
+  for (k = naxes - 1; k > a; k--)
+    p /= axes[k].nvalues;
+  return (int)(p % axes[a].nvalues);
+}
+
+/* value i of an axis as text, in buf if it is a number */
+static const char *axisvalue(const struct axis *ax, int i, char *buf)
+{
+  if (ax->isword)
+    return ax->words[i];
+  sprintf(buf, "%.10g", ax->values[i]);
+  return buf;
+}
+
+/* can a point branch from the common prefix, if there is one? */
+static int branchable(const struct simconfig *cfg, const struct simconfig *point)
+{
+  char changed[SIM_FORKNAMES];
+
+  if (cfg->forkat > 0.0 && !sim_forkable(cfg, point, changed)) {
+    fprintf(stderr, "sweep: %s cannot change after forkat\n", changed);
+    return 0;
+  }
+  return 1;
+}
+
+/* the configuration of every point, NULL if one is not valid */
+static struct simconfig *expand(const struct simconfig *cfg,
+                                const struct axis *axes, int naxes, long npoints)
+{
+  struct simconfig *cfgs;
+  char value[32];
+  long p;
+  int a;
+
+  cfgs = malloc(npoints * sizeof(struct simconfig));
+  if (cfgs == NULL) {
+    printf("memory allocation for sweep failed.");
+    exit(EXIT_FAILURE);
+  }
+  for (p = 0; p < npoints; p++) {
+    cfgs[p] = *cfg;
+    cfgs[p].sweep[0] = '\0';
+    for (a = 0; a < naxes; a++) {
+      if (config_set(&cfgs[p], axes[a].name,
+                     axisvalue(&axes[a], coord(axes, naxes, p, a), value)) != 0)
+        break;
+    }
+    if (a < naxes || config_check(&cfgs[p]) != 0 || protocol_check(&cfgs[p]) != 0
+        || !branchable(cfg, &cfgs[p])) {
+      fprintf(stderr, "sweep: point %ld is not valid\n", p + 1);
+      free(cfgs);
+      return NULL;
+    }
+  }
+  return cfgs;
+}
+
+static void report(const struct simconfig *cfg, const struct simconfig *cfgs,
+                   const struct axis *axes, int naxes,
+                   long npoints, const struct sim_results *res)
+{
+  struct summary sum;
+  char heading[NAMEMAX];
+  int reps = cfg->replications;
+  int format = report_format(cfg);
+  long p;
+  int a, m;
+
+  if (format != FORMAT_TEXT) {    /* one record per point, see report.h */
+    report_begin(format, 1);
+    for (p = 0; p < npoints; p++)
+      report_summary(format, &cfgs[p], &res[p * reps], reps);
+    return;
+  }
+
+  printf("# %ld points x %d replications of %d msgs, seed %lu, _ci = 95%% confidence half-width\n",
+         npoints, reps, cfg->nsimmax, cfg->seed);
+  for (a = 0; a < naxes; a++)
+    printf("%12s ", axes[a].name);
+  for (m = 0; m < NMETRICS; m++) {
+    sprintf(heading, "%s_ci", runner_metric_key(m));
+    printf("%12s %12s%s", runner_metric_key(m), heading, m + 1 < NMETRICS ? " " : "\n");
+  }
+  for (p = 0; p < npoints; p++) {
+    for (a = 0; a < naxes; a++)
+      if (axes[a].isword)
+        printf("%12s ", axes[a].words[coord(axes, naxes, p, a)]);
+      else
+        printf("%12.6g ", axes[a].values[coord(axes, naxes, p, a)]);
+    for (m = 0; m < NMETRICS; m++) {
+      runner_summarise(&res[p * reps], reps, m, &sum);
+      printf("%12.6g %12.6g%s", sum.mean, sum.ci95, m + 1 < NMETRICS ? " " : "\n");
+    }
+  }
+}
+
+int sweep_run(const struct simconfig *cfg)
+{
+  struct axis *axes;
+  struct simconfig *cfgs;
+  struct sim_results *res;
+  long npoints, runs;
+  int naxes, a;
+
+  axes = malloc(SWEEP_MAXAXES * sizeof(struct axis));
+  if (axes == NULL) {
+    printf("memory allocation for sweep failed.");
+    exit(EXIT_FAILURE);
+  }
+  naxes = parseaxes(cfg->sweep, axes);
+  /* checked before each product, which could otherwise overflow */
+  npoints = 1;
+  runs = cfg->replications;
+  for (a = 0; a < naxes; a++) {
+    if (runs > SWEEP_MAXRUNS / axes[a].nvalues) {
+      fprintf(stderr, "sweep: more than %ld runs\n", SWEEP_MAXRUNS);
+      naxes = -1;
+      break;
+    }
+    npoints *= axes[a].nvalues;
+    runs *= axes[a].nvalues;
+  }
+  cfgs = naxes > 0 ? expand(cfg, axes, naxes, npoints) : NULL;
+  if (cfgs == NULL) {
+    free(axes);
+    return -1;
+  }
+
+  res = malloc(npoints * cfg->replications * sizeof(struct sim_results));
+  if (res == NULL) {
+    printf("memory allocation for sweep failed.");
+    exit(EXIT_FAILURE);
+  }
+  runner_replicate(cfg, cfgs, (int)npoints, res);
+  report(cfg, cfgs, axes, naxes, npoints, res);
+
+  free(res);
+  free(cfgs);
+  free(axes);
+  return 0;
+}
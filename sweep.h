@@ -0,0 +1,39 @@
+/* ******************************************************************
+   Parameter sweeps.
+
+   cfg->sweep names one or more axes, separated by spaces or ';'.  Each
+   axis is a config parameter name and its values, either a list or an
+   inclusive start:stop:step range:
+
+       -sweep "loss=0:0.3:0.05 window=2,4,8,16"
+
+   A list of words sweeps a string parameter, e.g. "protocol=sr,gbn".
+   The grid of every combination is expanded (the last axis varies
+   fastest), each point gets cfg->replications runs, and all runs of all
+   points share one thread pool, see runner.h.  Every point uses the
+   same seed and replica numbers, so points differ only by the swept
+   parameters (common random numbers).  With -forkat T each replication
+   runs once up to time T with the unswept configuration, and every
+   point branches from a snapshot of it, so that common prefix is only
+   simulated once.
+
+   The result is one table on stdout: a row per point with the axis
+   values, then the mean and 95% confidence half-width of each
+   statistic.  With -format json or csv it is a record per point
+   instead, see report.h.
+**********************************************************************/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#define SWEEP_MAXAXES   8       /* parameters swept at once */
+#define SWEEP_MAXVALUES 1000    /* values along one axis */
+#define SWEEP_MAXRUNS   10000000L  /* points times replications */
+
+struct simconfig;
+
+/* run the sweep cfg->sweep describes, returns 0 or -1 if the sweep
+   or one of its points is not valid */
+extern int sweep_run(const struct simconfig *cfg);
+
+#endif
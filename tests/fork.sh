@@ -0,0 +1,52 @@
+#!/bin/sh
+# Forking from a snapshot: a branch that changes a parameter the
+# protocol state was set up for must be refused, one that does not must
+# carry on exactly as the unbroken run.
+#
+# usage: sh tests/fork.sh [path to sr]
+
+SR=${1:-./sr}
+DIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$DIR"' EXIT
+RUN="-messages 2000 -loss 0.1 -corrupt 0.05"
+failed=0
+
+fail() {
+  echo "FAIL: $1"
+  failed=1
+}
+
+# refused: $1 is the parameter the message must name, the rest the flags
+refused() {
+  name=$1
+  shift
+  if "$SR" "$@" > "$DIR/out" 2> "$DIR/err"; then
+    fail "$* was accepted"
+  elif ! grep "cannot change" "$DIR/err" | grep -q -w "$name"; then
+    fail "$* did not name $name: $(cat "$DIR/err")"
+  fi
+}
+
+"$SR" $RUN -forkat 5000 -snapshot "$DIR/uni.snap" > /dev/null || fail "snapshot"
+"$SR" $RUN -bidirectional 1 -forkat 5000 -snapshot "$DIR/bi.snap" > /dev/null || fail "bidirectional snapshot"
+
+refused bidirectional -resume "$DIR/uni.snap" -bidirectional 1
+refused bidirectional -resume "$DIR/bi.snap" -bidirectional 0
+refused ackdelay -resume "$DIR/bi.snap" -ackdelay 5
+refused window -resume "$DIR/uni.snap" -window 4
+refused bidirectional $RUN -forkat 1000 -sweep "bidirectional=0,1"
+
+# a branch with nothing changed is the unbroken run
+for mode in 0 1; do
+  "$SR" $RUN -bidirectional $mode > "$DIR/straight"
+  snap=uni.snap
+  [ $mode = 1 ] && snap=bi.snap
+  "$SR" -resume "$DIR/$snap" > "$DIR/resumed" || fail "resume with bidirectional $mode"
+  cmp -s "$DIR/straight" "$DIR/resumed" || fail "resumed run with bidirectional $mode differs"
+done
+
+# a branch may still change the channel
+"$SR" -resume "$DIR/uni.snap" -loss 0.2 > /dev/null || fail "resume with -loss 0.2"
+
+[ $failed = 0 ] && echo "fork tests passed"
+exit $failed
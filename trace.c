@@ -0,0 +1,45 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include "trace.h"
+
+/* ******************************************************************
+   Buffered trace sink, see trace.h
+**********************************************************************/
+
+static FILE *sink = NULL;              /* where trace output goes */
+static char sinkbuf[TRACE_BUFSIZE];    /* stdio buffer for the sink */
+
+void trace_open(const char *path)
+{
+  if (path == NULL)
+    sink = stdout;
+  else {
+    sink = fopen(path, "w");
+    if (sink == NULL) {
+      printf("unable to open trace file %s\n", path);
+      exit(EXIT_FAILURE);
+    }
+  }
+  setvbuf(sink, sinkbuf, _IOFBF, sizeof(sinkbuf));
+}
+
+void trace_printf(const char *format, ...)
+{
+  va_list ap;
+
+  va_start(ap, format);
+  vfprintf(sink != NULL ? sink : stdout, format, ap);
+  va_end(ap);
+}
+
+void trace_close(void)
+{
+  if (sink == NULL)
+    return;
+  if (sink == stdout)
+    fflush(sink);
+  else
+    fclose(sink);
+  sink = NULL;
+}
@@ -0,0 +1,41 @@
+/* ******************************************************************
+   Trace output for the emulator and the protocol code.
+
+   TRACEF(level, (format, args...)) prints when the runtime TRACE level
+   is at least level.  Levels above TRACE_MAX are compiled out, so a
+   build with -DTRACE_MAX=0 keeps only the level 0 warnings and pays
+   nothing for tracing on the hot paths.  The double parentheses let the
+   macro take a variable argument list in ANSI C.
+
+   Output goes to a fully buffered sink, standard output unless
+   trace_open() was given a file name.
+**********************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifndef TRACE_MAX
+#define TRACE_MAX 4       /* highest TRACE level compiled in */
+#endif
+
+#define TRACE_BUFSIZE 65536   /* size of the sink's stdio buffer */
+
+extern int TRACE;
+
+/* is output at this level wanted? constant false above TRACE_MAX */
+#define TRACE_ON(level) ((level) <= TRACE_MAX && TRACE >= (level))
+
+#define TRACEF(level, args) \
+  do { if (TRACE_ON(level)) trace_printf args; } while (0)
+
+/* open the trace sink, NULL for standard output.  Must be called
+   before anything else is written to the stream. */
+extern void trace_open(const char *path);
+
+/* write to the trace sink, as printf */
+extern void trace_printf(const char *format, ...);
+
+/* flush the trace sink, and close it if it is a file */
+extern void trace_close(void);
+
+#endif
@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "bintrace.h"
+
+/* ******************************************************************
+   tracedecode: print a binary event trace written by the emulator.
+
+   usage: tracedecode [-csv] tracefile
+
+   Build with: gcc -Wall -ansi -pedantic -o tracedecode tracedecode.c
+**********************************************************************/
+
+static const char *typename[] = { "timerinterrupt", "fromlayer5", "fromlayer3" };
+
+/* outcome flags as a "|" separated list, "-" if none */
+static const char *flagstring(int flags, char *buf)
+{
+  static const struct { int flag; const char *name; } names[] = {
+    { BT_CORRUPT, "corrupt" }, { BT_NEWACK, "newack" }, { BT_RESENT, "resent" },
+    { BT_WINFULL, "windowfull" }, { BT_NOMSG, "nomsg" }
+  };
+  int i;
+
+  buf[0] = '\0';
+  for (i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++)
+    if (flags & names[i].flag) {
+      if (buf[0] != '\0')
+        strcat(buf, "|");
+      strcat(buf, names[i].name);
+    }
+  return (buf[0] != '\0') ? buf : "-";
+}
+
+int main(int argc, char **argv)
+{
+  struct bthdr hdr;
+  struct btrec rec;
+  FILE *fp;
+  int csv = 0;
+  long n;
+  char flagbuf[64];
+  const char *type;
+
+  if (argc == 3 && strcmp(argv[1], "-csv") == 0)
+    csv = 1;
+  else if (argc != 2) {
+    fprintf(stderr, "usage: %s [-csv] tracefile\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  fp = fopen(argv[argc - 1], "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "%s: unable to open %s\n", argv[0], argv[argc - 1]);
+    return EXIT_FAILURE;
+  }
+  if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || strcmp(hdr.magic, BT_MAGIC) != 0
+      || hdr.recsize != (long)sizeof(struct btrec)) {
+    fprintf(stderr, "%s: %s is not a binary trace from this kind of machine\n",
+            argv[0], argv[argc - 1]);
+    return EXIT_FAILURE;
+  }
+
+  if (csv)
+    printf("time,type,entity,flow,seqnum,acknum,sent,delivered,flags\n");
+  else if (hdr.dropped > 0)
+    printf("(%ld older records were overwritten)\n", hdr.dropped);
+  for (n = 0; n < hdr.nrecs; n++) {
+    if (fread(&rec, sizeof(rec), 1, fp) != 1) {
+      fprintf(stderr, "%s: trace truncated after %ld records\n", argv[0], n);
+      return EXIT_FAILURE;
+    }
+    type = (rec.type < 3) ? typename[rec.type] : "unknown";
+    if (csv)
+      printf("%f,%s,%c,%d,%d,%d,%u,%u,%s\n", rec.time, type, rec.entity ? 'B' : 'A',
+             rec.flow, rec.seqnum, rec.acknum, rec.nsent, rec.ndelivered, flagstring(rec.flags, flagbuf));
+    else
+      printf("%12f %-15s %c flow %d seq %6d ack %6d  sent %u delivered %u  %s\n", rec.time,
+             type, rec.entity ? 'B' : 'A', rec.flow, rec.seqnum, rec.acknum, rec.nsent, rec.ndelivered,
+             flagstring(rec.flags, flagbuf));
+  }
+  fclose(fp);
+  return EXIT_SUCCESS;
+}